@@ -0,0 +1,142 @@
+/*
+Adafruit_ZeroDMA.h
+
+Host stand-in for the DMA library of the SAMD21, see `Arduino.h`. Moves no
+data, but keeps the timing of a job: a block of `count` bytes takes as long
+as the NeoPixel SPI at 2.4 MHz needs to send it, and the block interrupt,
+when enabled in the descriptor, fires on the board clock at the end of every
+block, see `TC_Board::advance()`.
+*/
+
+#ifndef TC_Adafruit_ZeroDMA_h
+#define TC_Adafruit_ZeroDMA_h
+
+#include "Arduino.h"
+
+#define DMAC_CH_NUM 12
+
+enum ZeroDMAstatus {
+  DMA_STATUS_OK = 0,
+  DMA_STATUS_ERR_NOT_FOUND,
+  DMA_STATUS_ERR_NOT_INITIALIZED,
+  DMA_STATUS_ERR_INVALID_ARG,
+  DMA_STATUS_ERR_IO,
+  DMA_STATUS_ERR_TIMEOUT,
+  DMA_STATUS_BUSY,
+  DMA_STATUS_SUSPEND,
+  DMA_STATUS_ABORTED,
+  DMA_STATUS_JOBSTATUS = -1
+};
+
+enum dma_transfer_trigger_action {
+  DMA_TRIGGER_ACTON_BLOCK = 0,
+  DMA_TRIGGER_ACTON_BEAT = 2,
+  DMA_TRIGGER_ACTON_TRANSACTION = 3
+};
+
+enum dma_callback_type {
+  DMA_CALLBACK_TRANSFER_DONE,
+  DMA_CALLBACK_TRANSFER_ERROR,
+  DMA_CALLBACK_CHANNEL_SUSPEND,
+  DMA_CALLBACK_N
+};
+
+enum dma_beat_size {
+  DMA_BEAT_SIZE_BYTE,
+  DMA_BEAT_SIZE_HWORD,
+  DMA_BEAT_SIZE_WORD
+};
+
+enum dma_block_action {
+  DMA_BLOCK_ACTION_NOACT,
+  DMA_BLOCK_ACTION_INT,
+  DMA_BLOCK_ACTION_SUSPEND,
+  DMA_BLOCK_ACTION_BOTH
+};
+
+enum dma_step_selection { DMA_STEPSEL_DST = 0, DMA_STEPSEL_SRC };
+
+enum dma_address_increment_stepsize { DMA_ADDRESS_INCREMENT_STEP_SIZE_1 = 0 };
+
+enum dma_priority {
+  DMA_PRIORITY_0,
+  DMA_PRIORITY_1,
+  DMA_PRIORITY_2,
+  DMA_PRIORITY_3
+};
+
+struct DmacDescriptor {
+  union {
+    struct {
+      uint16_t VALID : 1;
+      uint16_t EVOSEL : 2;
+      uint16_t BLOCKACT : 2;
+      uint16_t : 3;
+      uint16_t BEATSIZE : 2;
+      uint16_t SRCINC : 1;
+      uint16_t DSTINC : 1;
+      uint16_t STEPSEL : 1;
+      uint16_t STEPSIZE : 3;
+    } bit;
+    uint16_t reg;
+  } BTCTRL;
+  struct {
+    uint16_t reg;
+  } BTCNT;
+  struct {
+    uint32_t reg;
+  } SRCADDR, DSTADDR, DESCADDR;
+};
+
+class Adafruit_ZeroDMA {
+ public:
+  Adafruit_ZeroDMA(void);
+
+  ZeroDMAstatus allocate(void);
+  ZeroDMAstatus startJob(void);
+  ZeroDMAstatus free(void);
+  void trigger(void) {}
+  void setTrigger(uint8_t trigger) { peripheralTrigger = trigger; }
+  void setAction(dma_transfer_trigger_action action) {
+    triggerAction = action;
+  }
+  void setCallback(void (*callback)(Adafruit_ZeroDMA *) = NULL,
+                   dma_callback_type type = DMA_CALLBACK_TRANSFER_DONE);
+  void loop(boolean flag) { loopFlag = flag; }
+  void suspend(void) {}
+  void resume(void) {}
+  void abort(void);
+  void setPriority(dma_priority) {}
+  uint8_t getChannel(void) { return channel; }
+
+  // One descriptor per channel, which is all the NeoPixel library uses
+  DmacDescriptor *
+  addDescriptor(void *src, void *dst, uint32_t count = 0,
+                dma_beat_size size = DMA_BEAT_SIZE_BYTE, bool srcInc = true,
+                bool dstInc = true,
+                uint32_t stepSize = DMA_ADDRESS_INCREMENT_STEP_SIZE_1,
+                bool stepSel = DMA_STEPSEL_DST);
+  void changeDescriptor(DmacDescriptor *d, void *src = NULL, void *dst = NULL,
+                        uint32_t count = 0);
+  bool isActive(void);
+
+  // Block done at `_tBlockEnd` on the board clock, called by
+  // `TC_Board::advance()`
+  void _IRQhandler(uint8_t flags);
+  uint64_t _tBlockEnd; // [us]
+
+ protected:
+  uint8_t channel;
+  volatile enum ZeroDMAstatus jobStatus;
+  bool hasDescriptors;
+  bool loopFlag;
+  uint8_t peripheralTrigger;
+  dma_transfer_trigger_action triggerAction;
+  void (*callback[DMA_CALLBACK_N])(Adafruit_ZeroDMA *);
+  DmacDescriptor descriptor;
+
+  // Duration of a block [us]
+  uint32_t blockTime(void);
+};
+
+#endif
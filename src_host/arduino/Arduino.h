@@ -0,0 +1,257 @@
+/*
+Arduino.h
+
+Host stand-in for the Arduino SAMD core of the Arduino M0 Pro, just enough of
+it to build the firmware in `src_mcu` on the host, see `TC_Board.h`. Time is
+virtual: `micros()` and `millis()` only move when the host advances the board
+clock, and interrupts only fire in between, so `noInterrupts()` has nothing
+to do. Pins, I2C and SPI are accepted and ignored.
+*/
+
+#ifndef TC_Arduino_h
+#define TC_Arduino_h
+
+#include <algorithm>
+#include <ctype.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define USB_PID 0x804d // Arduino Zero and M0 Pro, see pins.h of the NeoPixel
+                       // DMA library
+#define F_CPU 48000000L
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+
+using std::max;
+using std::min;
+#define constrain(amt, low, high)                                              \
+  ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// Time, on the virtual clock of `TC_Board`
+unsigned long micros(void);
+unsigned long millis(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+static inline void yield(void) {}
+
+// Pins
+void pinMode(uint32_t pin, uint32_t mode);
+void digitalWrite(uint32_t pin, uint32_t value);
+int digitalRead(uint32_t pin);
+#define PIN_SPI_MOSI 23
+#define MOSI PIN_SPI_MOSI
+extern volatile uint32_t tc_port_out[2];
+extern volatile uint32_t tc_port_dir[2];
+#define digitalPinToPort(p) ((p) >> 5)
+#define digitalPinToBitMask(p) (1ul << ((p) & 31))
+#define portOutputRegister(port) (&tc_port_out[port])
+#define portModeRegister(port) (&tc_port_dir[port])
+
+// Interrupts and core registers
+static inline void __disable_irq(void) {}
+static inline void __enable_irq(void) {}
+static inline uint32_t __get_PRIMASK(void) { return 0; }
+static inline void __set_PRIMASK(uint32_t) {}
+static inline void __DSB(void) {}
+static inline void __NOP(void) {}
+#define noInterrupts() __disable_irq()
+#define interrupts() __enable_irq()
+
+// Counts down from `LOAD` to 0 once per millisecond, see `TC_Board::advance()`
+struct SysTick_Type {
+  volatile uint32_t CTRL;
+  volatile uint32_t LOAD;
+  volatile uint32_t VAL;
+  volatile uint32_t CALIB;
+};
+extern SysTick_Type *SysTick;
+#define SysTick_LOAD_RELOAD_Msk 0xFFFFFFul
+#define SysTick_CTRL_COUNTFLAG_Msk (1ul << 16)
+
+// Endpoint status of the native USB port. The IN bank is always free.
+struct UsbDeviceEndpoint {
+  union {
+    struct {
+      uint8_t DTGLOUT : 1;
+      uint8_t DTGLIN : 1;
+      uint8_t CURBK : 1;
+      uint8_t : 1;
+      uint8_t STALLRQ0 : 1;
+      uint8_t STALLRQ1 : 1;
+      uint8_t BK0RDY : 1;
+      uint8_t BK1RDY : 1;
+    } bit;
+    uint8_t reg;
+  } EPSTATUS;
+};
+struct UsbDevice {
+  UsbDeviceEndpoint DeviceEndpoint[8];
+};
+struct Usb {
+  UsbDevice DEVICE;
+};
+extern Usb *USB;
+
+// SERCOM peripherals, for the SPI of the NeoPixel DMA library
+class SERCOM {};
+struct Sercom {
+  struct {
+    struct {
+      volatile uint32_t reg;
+    } DATA;
+  } SPI;
+};
+extern SERCOM sercom0, sercom1, sercom2, sercom3, sercom4, sercom5;
+extern Sercom tc_sercom_regs[6];
+#define SERCOM0 (&tc_sercom_regs[0])
+#define SERCOM1 (&tc_sercom_regs[1])
+#define SERCOM2 (&tc_sercom_regs[2])
+#define SERCOM3 (&tc_sercom_regs[3])
+#define SERCOM4 (&tc_sercom_regs[4])
+#define SERCOM5 (&tc_sercom_regs[5])
+#define SERCOM0_DMAC_ID_TX 2
+#define SERCOM1_DMAC_ID_TX 4
+#define SERCOM2_DMAC_ID_TX 6
+#define SERCOM3_DMAC_ID_TX 8
+#define SERCOM4_DMAC_ID_TX 10
+#define SERCOM5_DMAC_ID_TX 12
+enum SercomSpiTXPad {
+  SPI_PAD_0_SCK_1 = 0,
+  SPI_PAD_2_SCK_3,
+  SPI_PAD_3_SCK_1,
+  SPI_PAD_0_SCK_3
+};
+enum SercomRXPad {
+  SERCOM_RX_PAD_0 = 0,
+  SERCOM_RX_PAD_1,
+  SERCOM_RX_PAD_2,
+  SERCOM_RX_PAD_3
+};
+enum EPioType { PIO_SERCOM, PIO_SERCOM_ALT };
+#define SPI_INTERFACES_COUNT 1
+#define PAD_SPI_TX SPI_PAD_2_SCK_3
+
+// Print and Stream, with the number formatting of the Arduino core
+class __FlashStringHelper;
+#define F(string_literal)                                                      \
+  (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+class Print {
+ public:
+  virtual ~Print() {}
+
+  virtual size_t write(uint8_t) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *str) {
+    return str ? write((const uint8_t *)str, strlen(str)) : 0;
+  }
+  size_t write(const char *buffer, size_t size) {
+    return write((const uint8_t *)buffer, size);
+  }
+  virtual int availableForWrite() { return 0; }
+  virtual void flush() {}
+
+  size_t print(const __FlashStringHelper *s);
+  size_t print(const char s[]);
+  size_t print(char c);
+  size_t print(unsigned char n, int base = DEC);
+  size_t print(int n, int base = DEC);
+  size_t print(unsigned int n, int base = DEC);
+  size_t print(long n, int base = DEC);
+  size_t print(unsigned long n, int base = DEC);
+  size_t print(double n, int digits = 2);
+
+  size_t println(const __FlashStringHelper *s);
+  size_t println(const char s[]);
+  size_t println(char c);
+  size_t println(unsigned char n, int base = DEC);
+  size_t println(int n, int base = DEC);
+  size_t println(unsigned int n, int base = DEC);
+  size_t println(long n, int base = DEC);
+  size_t println(unsigned long n, int base = DEC);
+  size_t println(double n, int digits = 2);
+  size_t println(void);
+
+ private:
+  size_t printNumber(unsigned long n, uint8_t base);
+  size_t printFloat(double number, uint8_t digits);
+};
+
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  // Never waits: the clock stands still while the firmware runs
+  size_t readBytes(char *buffer, size_t length);
+  size_t readBytes(uint8_t *buffer, size_t length) {
+    return readBytes((char *)buffer, length);
+  }
+  void setTimeout(unsigned long) {}
+};
+
+// Serial port of the board, its bytes are exchanged with the host through
+// `TC_Board::receive()` and `TC_Board::takeSent()`. There is no baud rate:
+// whatever the firmware writes reaches the host at once.
+class TC_BoardSerial : public Stream {
+ public:
+  TC_BoardSerial(uint8_t port, int txSpace)
+      : _port(port), _txSpace(txSpace) {}
+
+  void begin(unsigned long) {}
+  void end() {}
+  int available();
+  int read();
+  int peek();
+  size_t readBytes(char *buffer, size_t length);
+  size_t write(uint8_t c) { return write(&c, 1); }
+  size_t write(const uint8_t *buffer, size_t size);
+  using Print::write;
+  int availableForWrite() { return _txSpace; }
+  operator bool() { return true; }
+
+ private:
+  uint8_t _port;
+  int _txSpace;
+};
+
+// Programming port, the EDBG bridge
+class Uart : public TC_BoardSerial {
+ public:
+  explicit Uart(uint8_t port) : TC_BoardSerial(port, 350) {}
+};
+
+// Native USB port, with a terminal attached
+class Serial_ : public TC_BoardSerial {
+ public:
+  explicit Serial_(uint8_t port) : TC_BoardSerial(port, 63) {}
+  bool dtr() { return true; }
+  bool rts() { return true; }
+};
+
+extern Uart Serial;
+extern Serial_ SerialUSB;
+
+#endif
@@ -0,0 +1,41 @@
+/*
+SPI.h
+
+Host stand-in for the SPI library of the Arduino SAMD core, see `Arduino.h`.
+Only what the NeoPixel DMA library needs to set up its SERCOM.
+*/
+
+#ifndef TC_SPI_h
+#define TC_SPI_h
+
+#include "Arduino.h"
+
+#define SPI_MODE0 0x02
+#define SPI_MODE1 0x00
+#define SPI_MODE2 0x03
+#define SPI_MODE3 0x01
+
+enum BitOrder { LSBFIRST = 0, MSBFIRST = 1 };
+
+class SPISettings {
+ public:
+  SPISettings(uint32_t, BitOrder, uint8_t) {}
+  SPISettings() {}
+};
+
+class SPIClassSAMD {
+ public:
+  SPIClassSAMD(SERCOM *, uint8_t, uint8_t, uint8_t, SercomSpiTXPad,
+               SercomRXPad) {}
+
+  void begin() {}
+  void end() {}
+  void beginTransaction(SPISettings) {}
+  void endTransaction(void) {}
+  uint8_t transfer(uint8_t) { return 0; }
+};
+
+extern SPIClassSAMD SPI;
+#define SPI SPI
+
+#endif
@@ -0,0 +1,425 @@
+#include "TC_Board.h"
+
+#include "Adafruit_ZeroDMA.h"
+#include "Arduino.h"
+#include "SPI.h"
+#include "Wire.h"
+#include "wiring_private.h"
+
+// CLOCK
+// -----
+
+static uint64_t t_board = 0; // [us]
+
+static SysTick_Type sysTickRegs = {0, F_CPU / 1000 - 1, F_CPU / 1000 - 1, 0};
+SysTick_Type *SysTick = &sysTickRegs;
+
+// Called by the SysTick interrupt, like the weak hook of the SAMD core.
+// Returning 0 lets the core go on with its own handling.
+extern "C" int sysTickHook(void) __attribute__((weak));
+extern "C" int sysTickHook(void) { return 0; }
+
+static void updateSysTick() {
+  SysTick->VAL = SysTick->LOAD - (uint32_t)(t_board % 1000) * (F_CPU / 1000000);
+}
+
+unsigned long micros(void) { return (uint32_t)t_board; }
+
+unsigned long millis(void) { return (uint32_t)(t_board / 1000); }
+
+void delay(unsigned long ms) { TC_Board::advance((uint64_t)ms * 1000); }
+
+void delayMicroseconds(unsigned int us) { TC_Board::advance(us); }
+
+// DMA
+// ---
+// Channels with a job, by channel number
+
+static Adafruit_ZeroDMA *dmaChannels[DMAC_CH_NUM];
+
+Adafruit_ZeroDMA::Adafruit_ZeroDMA(void) {
+  _tBlockEnd = 0;
+  channel = 0xFF;
+  jobStatus = DMA_STATUS_OK;
+  hasDescriptors = false;
+  loopFlag = false;
+  peripheralTrigger = 0;
+  triggerAction = DMA_TRIGGER_ACTON_BEAT;
+  memset(callback, 0, sizeof(callback));
+  memset(&descriptor, 0, sizeof(descriptor));
+}
+
+ZeroDMAstatus Adafruit_ZeroDMA::allocate(void) {
+  if (channel < DMAC_CH_NUM) return DMA_STATUS_OK;
+  for (uint8_t i = 0; i < DMAC_CH_NUM; i++) {
+    if (!dmaChannels[i]) {
+      dmaChannels[i] = this;
+      channel = i;
+      return DMA_STATUS_OK;
+    }
+  }
+  return DMA_STATUS_ERR_NOT_FOUND;
+}
+
+ZeroDMAstatus Adafruit_ZeroDMA::free(void) {
+  if (channel >= DMAC_CH_NUM) return DMA_STATUS_ERR_NOT_INITIALIZED;
+  if (jobStatus == DMA_STATUS_BUSY) return DMA_STATUS_BUSY;
+  dmaChannels[channel] = NULL;
+  channel = 0xFF;
+  return DMA_STATUS_OK;
+}
+
+ZeroDMAstatus Adafruit_ZeroDMA::startJob(void) {
+  if (channel >= DMAC_CH_NUM) return DMA_STATUS_ERR_NOT_INITIALIZED;
+  if (!hasDescriptors || !descriptor.BTCNT.reg) {
+    return DMA_STATUS_ERR_INVALID_ARG;
+  }
+  jobStatus = DMA_STATUS_BUSY;
+  _tBlockEnd = t_board + blockTime();
+  return DMA_STATUS_OK;
+}
+
+void Adafruit_ZeroDMA::abort(void) {
+  if (jobStatus == DMA_STATUS_BUSY) jobStatus = DMA_STATUS_ABORTED;
+}
+
+void Adafruit_ZeroDMA::setCallback(void (*cb)(Adafruit_ZeroDMA *),
+                                   dma_callback_type type) {
+  callback[type] = cb;
+}
+
+DmacDescriptor *Adafruit_ZeroDMA::addDescriptor(void *src, void *dst,
+                                                uint32_t count,
+                                                dma_beat_size size, bool srcInc,
+                                                bool dstInc, uint32_t stepSize,
+                                                bool stepSel) {
+  if (channel >= DMAC_CH_NUM || hasDescriptors) return NULL;
+  descriptor.BTCTRL.bit.VALID = true;
+  descriptor.BTCTRL.bit.BLOCKACT = DMA_BLOCK_ACTION_NOACT;
+  descriptor.BTCTRL.bit.BEATSIZE = size;
+  descriptor.BTCTRL.bit.SRCINC = srcInc;
+  descriptor.BTCTRL.bit.DSTINC = dstInc;
+  descriptor.BTCTRL.bit.STEPSEL = stepSel;
+  descriptor.BTCTRL.bit.STEPSIZE = stepSize;
+  descriptor.BTCNT.reg = count;
+  descriptor.SRCADDR.reg = (uint32_t)(uintptr_t)src;
+  descriptor.DSTADDR.reg = (uint32_t)(uintptr_t)dst;
+  hasDescriptors = true;
+  return &descriptor;
+}
+
+void Adafruit_ZeroDMA::changeDescriptor(DmacDescriptor *d, void *src,
+                                        void *dst, uint32_t count) {
+  if (src) d->SRCADDR.reg = (uint32_t)(uintptr_t)src;
+  if (dst) d->DSTADDR.reg = (uint32_t)(uintptr_t)dst;
+  if (count) d->BTCNT.reg = count;
+}
+
+bool Adafruit_ZeroDMA::isActive(void) { return jobStatus == DMA_STATUS_BUSY; }
+
+void Adafruit_ZeroDMA::_IRQhandler(uint8_t flags) {
+  (void)flags;
+  if (loopFlag) {
+    _tBlockEnd += blockTime();
+  } else {
+    jobStatus = DMA_STATUS_OK;
+  }
+  if (descriptor.BTCTRL.bit.BLOCKACT == DMA_BLOCK_ACTION_INT &&
+      callback[DMA_CALLBACK_TRANSFER_DONE]) {
+    callback[DMA_CALLBACK_TRANSFER_DONE](this);
+  }
+}
+
+uint32_t Adafruit_ZeroDMA::blockTime(void) {
+  // 8 bits at 2.4 MHz per byte
+  return ((uint32_t)descriptor.BTCNT.reg * 10 + 2) / 3;
+}
+
+// BOARD
+// -----
+
+uint64_t TC_Board::time() { return t_board; }
+
+void TC_Board::setTime(uint64_t t) {
+  t_board = t;
+  updateSysTick();
+  for (uint8_t i = 0; i < DMAC_CH_NUM; i++) {
+    Adafruit_ZeroDMA *dma = dmaChannels[i];
+    if (dma && dma->isActive() && dma->_tBlockEnd <= t) {
+      dma->_tBlockEnd = t + 1; // Resumes with the next interrupt
+    }
+  }
+}
+
+void TC_Board::advance(uint64_t dt) {
+  uint64_t t_end = t_board + dt;
+
+  for (;;) {
+    // Next interrupt: the SysTick at the next millisecond or a DMA block
+    uint64_t t_next = (t_board / 1000 + 1) * 1000;
+    for (uint8_t i = 0; i < DMAC_CH_NUM; i++) {
+      Adafruit_ZeroDMA *dma = dmaChannels[i];
+      if (dma && dma->isActive() && dma->_tBlockEnd < t_next) {
+        t_next = dma->_tBlockEnd;
+      }
+    }
+    if (t_next > t_end) break;
+
+    t_board = t_next;
+    if (t_next % 1000 == 0) {
+      sysTickHook();
+    }
+    for (uint8_t i = 0; i < DMAC_CH_NUM; i++) {
+      Adafruit_ZeroDMA *dma = dmaChannels[i];
+      if (dma && dma->isActive() && dma->_tBlockEnd == t_next) {
+        dma->_IRQhandler(i);
+      }
+    }
+  }
+  t_board = t_end;
+  updateSysTick();
+}
+
+// SERIAL PORTS
+// ------------
+
+struct PortBuffers {
+  std::string rx;
+  size_t rxPos = 0; // Next byte of `rx` to read
+  std::string tx;
+};
+
+static PortBuffers ports[TC_Board::N_PORTS];
+
+Uart Serial(TC_Board::PORT_SERIAL);
+Serial_ SerialUSB(TC_Board::PORT_USB);
+
+void TC_Board::receive(Port port, const char *data, size_t len) {
+  PortBuffers &p = ports[port];
+  if (p.rxPos == p.rx.size()) {
+    p.rx.clear();
+    p.rxPos = 0;
+  }
+  p.rx.append(data, len);
+}
+
+std::string TC_Board::takeSent(Port port) {
+  std::string sent;
+  sent.swap(ports[port].tx);
+  return sent;
+}
+
+int TC_BoardSerial::available() {
+  return (int)(ports[_port].rx.size() - ports[_port].rxPos);
+}
+
+int TC_BoardSerial::read() {
+  PortBuffers &p = ports[_port];
+  return (p.rxPos < p.rx.size() ? (uint8_t)p.rx[p.rxPos++] : -1);
+}
+
+int TC_BoardSerial::peek() {
+  PortBuffers &p = ports[_port];
+  return (p.rxPos < p.rx.size() ? (uint8_t)p.rx[p.rxPos] : -1);
+}
+
+size_t TC_BoardSerial::readBytes(char *buffer, size_t length) {
+  PortBuffers &p = ports[_port];
+  size_t n = p.rx.size() - p.rxPos;
+  if (n > length) n = length;
+  memcpy(buffer, p.rx.data() + p.rxPos, n);
+  p.rxPos += n;
+  return n;
+}
+
+size_t TC_BoardSerial::write(const uint8_t *buffer, size_t size) {
+  ports[_port].tx.append((const char *)buffer, size);
+  return size;
+}
+
+// PRINT
+// -----
+// Same formatting as Print.cpp of the Arduino core
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (size--) {
+    if (write(*buffer++)) {
+      n++;
+    } else {
+      break;
+    }
+  }
+  return n;
+}
+
+size_t Print::print(const __FlashStringHelper *s) {
+  return write((const char *)s);
+}
+
+size_t Print::print(const char s[]) { return write(s); }
+
+size_t Print::print(char c) { return write((uint8_t)c); }
+
+size_t Print::print(unsigned char n, int base) {
+  return print((unsigned long)n, base);
+}
+
+size_t Print::print(int n, int base) { return print((long)n, base); }
+
+size_t Print::print(unsigned int n, int base) {
+  return print((unsigned long)n, base);
+}
+
+size_t Print::print(long n, int base) {
+  if (base == 0) {
+    return write((uint8_t)n);
+  } else if (base == 10 && n < 0) {
+    return print('-') + printNumber((unsigned long)-n, 10);
+  }
+  return printNumber((unsigned long)n, base);
+}
+
+size_t Print::print(unsigned long n, int base) {
+  if (base == 0) return write((uint8_t)n);
+  return printNumber(n, base);
+}
+
+size_t Print::print(double n, int digits) { return printFloat(n, digits); }
+
+size_t Print::println(const __FlashStringHelper *s) {
+  return print(s) + println();
+}
+
+size_t Print::println(const char s[]) { return print(s) + println(); }
+
+size_t Print::println(char c) { return print(c) + println(); }
+
+size_t Print::println(unsigned char n, int base) {
+  return print(n, base) + println();
+}
+
+size_t Print::println(int n, int base) { return print(n, base) + println(); }
+
+size_t Print::println(unsigned int n, int base) {
+  return print(n, base) + println();
+}
+
+size_t Print::println(long n, int base) { return print(n, base) + println(); }
+
+size_t Print::println(unsigned long n, int base) {
+  return print(n, base) + println();
+}
+
+size_t Print::println(double n, int digits) {
+  return print(n, digits) + println();
+}
+
+size_t Print::println(void) { return write("\r\n"); }
+
+size_t Print::printNumber(unsigned long n, uint8_t base) {
+  char buf[8 * sizeof(long) + 1];
+  char *str = &buf[sizeof(buf) - 1];
+
+  *str = '\0';
+  if (base < 2) base = 10;
+  do {
+    char c = n % base;
+    n /= base;
+    *--str = c < 10 ? c + '0' : c + 'A' - 10;
+  } while (n);
+  return write(str);
+}
+
+size_t Print::printFloat(double number, uint8_t digits) {
+  size_t n = 0;
+
+  if (isnan(number)) return print("nan");
+  if (isinf(number)) return print("inf");
+  if (number > 4294967040.0) return print("ovf");
+  if (number < -4294967040.0) return print("ovf");
+
+  if (number < 0.0) {
+    n += print('-');
+    number = -number;
+  }
+
+  double rounding = 0.5;
+  for (uint8_t i = 0; i < digits; ++i) {
+    rounding /= 10.0;
+  }
+  number += rounding;
+
+  unsigned long int_part = (unsigned long)number;
+  double remainder = number - (double)int_part;
+  n += print(int_part);
+
+  if (digits > 0) {
+    n += print('.');
+  }
+  while (digits-- > 0) {
+    remainder *= 10.0;
+    unsigned int toPrint = (unsigned int)remainder;
+    n += print(toPrint);
+    remainder -= toPrint;
+  }
+  return n;
+}
+
+size_t Stream::readBytes(char *buffer, size_t length) {
+  size_t count = 0;
+  int c;
+
+  while (count < length && (c = read()) >= 0) {
+    *buffer++ = (char)c;
+    count++;
+  }
+  return count;
+}
+
+// PERIPHERALS
+// -----------
+
+volatile uint32_t tc_port_out[2];
+volatile uint32_t tc_port_dir[2];
+
+void pinMode(uint32_t pin, uint32_t mode) {
+  uint32_t mask = digitalPinToBitMask(pin);
+  if (mode == OUTPUT) {
+    tc_port_dir[digitalPinToPort(pin)] |= mask;
+  } else {
+    tc_port_dir[digitalPinToPort(pin)] &= ~mask;
+  }
+}
+
+void digitalWrite(uint32_t pin, uint32_t value) {
+  uint32_t mask = digitalPinToBitMask(pin);
+  if (value) {
+    tc_port_out[digitalPinToPort(pin)] |= mask;
+  } else {
+    tc_port_out[digitalPinToPort(pin)] &= ~mask;
+  }
+}
+
+int digitalRead(uint32_t pin) {
+  return (tc_port_out[digitalPinToPort(pin)] & digitalPinToBitMask(pin)) ? HIGH
+                                                                         : LOW;
+}
+
+int pinPeripheral(uint32_t, EPioType) { return 0; }
+
+bool TC_Board::pin(uint32_t pin) { return digitalRead(pin) == HIGH; }
+
+static Usb usbRegs;
+Usb *USB = &usbRegs;
+
+SERCOM sercom0, sercom1, sercom2, sercom3, sercom4, sercom5;
+Sercom tc_sercom_regs[6];
+
+SPIClassSAMD SPI(&sercom4, MOSI, MOSI, MOSI, PAD_SPI_TX, SERCOM_RX_PAD_0);
+TwoWire Wire;
+
+// Bit-banged show() of the Adafruit_NeoPixel base class, selected with
+// `KENDRYTE_K210` as the one architecture that calls out to a function of
+// its own. Never called: the DMA strip has its own show().
+extern "C" void k210Show(uint8_t, uint8_t *, uint32_t, boolean) {}
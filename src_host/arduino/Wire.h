@@ -0,0 +1,44 @@
+/*
+Wire.h
+
+Host stand-in for the I2C library of the Arduino SAMD core, see `Arduino.h`.
+Transmissions succeed at once and reads return 0.
+*/
+
+#ifndef TC_Wire_h
+#define TC_Wire_h
+
+#include "Arduino.h"
+
+class TwoWire : public Stream {
+ public:
+  void begin(void) {}
+  void end(void) {}
+  void setClock(uint32_t) {}
+
+  void beginTransmission(uint8_t) {}
+  uint8_t endTransmission(bool = true) { return 0; }
+  uint8_t requestFrom(uint8_t, size_t quantity, bool = true) {
+    _rxLeft = quantity;
+    return quantity;
+  }
+
+  size_t write(uint8_t) { return 1; }
+  size_t write(const uint8_t *, size_t size) { return size; }
+  using Print::write;
+
+  int available(void) { return (int)_rxLeft; }
+  int read(void) {
+    if (!_rxLeft) return -1;
+    _rxLeft--;
+    return 0;
+  }
+  int peek(void) { return _rxLeft ? 0 : -1; }
+
+ private:
+  size_t _rxLeft = 0;
+};
+
+extern TwoWire Wire;
+
+#endif
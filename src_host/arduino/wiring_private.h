@@ -0,0 +1,14 @@
+/*
+wiring_private.h
+
+Host stand-in of the Arduino SAMD core, see `Arduino.h`
+*/
+
+#ifndef TC_wiring_private_h
+#define TC_wiring_private_h
+
+#include "Arduino.h"
+
+int pinPeripheral(uint32_t pin, EPioType peripheral);
+
+#endif
@@ -0,0 +1,53 @@
+/*
+TC_Board.h
+
+The Arduino M0 Pro as seen by the firmware sources when they are built on the
+host, against the stand-in Arduino core in `src_host/arduino`. The board has a
+virtual 64-bit clock in [us], from which `micros()` and `millis()` are taken.
+The clock stands still while firmware code runs and only moves on
+`advance()`, which also runs the interrupts falling due in between: the
+SysTick once per millisecond and the block interrupts of the DMA channels.
+
+The serial ports hand their bytes to and from the host at once, without any
+baud rate. Everything here is global, like the hardware it stands in for.
+*/
+
+#ifndef TC_Board_h
+#define TC_Board_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class TC_Board {
+public:
+  enum Port : uint8_t {
+    PORT_SERIAL = 0, // `Serial`, the programming port
+    PORT_USB = 1,    // `SerialUSB`, the native USB port
+    N_PORTS = 2
+  };
+
+  // Board clock [us]
+  static uint64_t time();
+
+  // Jump the clock to `t` without running the interrupts in between, e.g. to
+  // start right before `micros()` wraps around. Running DMA jobs resume from
+  // the start of a block.
+  static void setTime(uint64_t t);
+
+  // Move the clock forward by `dt` [us], running the interrupts that fall
+  // due on the way
+  static void advance(uint64_t dt);
+
+  // Bytes arriving on a serial port of the board
+  static void receive(Port port, const char *data, size_t len);
+
+  // Bytes written by the firmware to a serial port since the previous call
+  static std::string takeSent(Port port);
+
+  // Level the firmware drives on digital pin `pin`, e.g. a trigger out meant
+  // for a scope
+  static bool pin(uint32_t pin);
+};
+
+#endif
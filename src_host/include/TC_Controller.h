@@ -0,0 +1,142 @@
+/*
+TC_Controller.h
+
+Typed, asynchronous host API over the serial protocol of the Mini
+Taylor-Couette firmware, see `TC_Protocol.h`. Each request writes one command
+and returns a `std::future` that is fulfilled once the matching reply line has
+been received. Requests are pipelined: several can be in flight at the same
+time and are matched to their replies in order of sending.
+
+Lines the firmware sends on its own accord, see `isAsyncLine()`, and lines
+arriving while no request is pending are handed to the optional
+unsolicited-line callback. Telemetry records go to the telemetry callback.
+
+Works on any character device, i.e. a real serial port like `/dev/ttyACM0` or
+the pseudo-terminal of `TC_Simulator`. The firmware answers on both its
+programming and its native USB port, see `TC_Protocol.h`.
+*/
+
+#ifndef TC_Controller_h
+#define TC_Controller_h
+
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "DvG_Telemetry.h"
+#include "TC_Protocol.h"
+
+class TC_Controller {
+public:
+  explicit TC_Controller(const std::string &port, int baudrate = 115200);
+  ~TC_Controller();
+
+  TC_Controller(const TC_Controller &) = delete;
+  TC_Controller &operator=(const TC_Controller &) = delete;
+
+  // Open the port and start the reader thread. Throws `std::runtime_error`.
+  void open();
+
+  // Stop the reader thread and close the port. Pending requests fail with a
+  // `std::runtime_error`.
+  void close();
+
+  bool isOpen() const { return _fd >= 0; }
+
+  // Called from the reader thread for every line that does not answer a
+  // pending request
+  void setUnsolicitedCallback(std::function<void(const std::string &)> cb);
+
+  // Called from the reader thread for every decoded telemetry record
+  void setTelemetryCallback(
+      std::function<void(const DvG_TelemetryRecord &)> cb);
+
+  // Number of runs of telemetry records lost in transit
+  uint32_t telemetryGaps();
+
+  // Send any command and receive its raw reply line
+  std::future<std::string> query(const std::string &cmd);
+
+  std::future<std::string> identify();
+  std::future<uint8_t> brightnessUp();
+  std::future<uint8_t> brightnessDown();
+  std::future<bool> toggleWhite();
+  std::future<bool> toggleGreen();
+  std::future<TC_SpeedState> setSpeed(float rev_per_sec);
+  std::future<TC_SpeedState> nudgeSlower();
+  std::future<TC_SpeedState> nudgeFaster();
+  std::future<TC_SpeedState> setStyle(TC_Style style);
+
+  // Resolves to true when the motor is running afterwards
+  std::future<bool> toggleRun();
+
+  // Resolves to true when latency reports are enabled afterwards. Parse the
+  // reports arriving at the unsolicited-line callback with
+  // `parseLatencyReport()`.
+  std::future<bool> toggleLatencyReport();
+
+  // Stream telemetry every `period_ms`, 0: stop. Resolves to the period the
+  // firmware settled on, 0 when stopped.
+  std::future<uint32_t> setTelemetry(uint32_t period_ms);
+
+  // Read the device clock [us]
+  std::future<uint64_t> clock();
+
+  // Execute `cmd` at device clock `t_us`, at the step boundary nearest to
+  // it. Resolves to true when queued. The reply of the command arrives later
+  // at the unsolicited-line callback, parse it with `parseTimedReport()`.
+  std::future<bool> at(uint64_t t_us, const std::string &cmd);
+
+  // Replace the script of the firmware by `script`, sent as binary frames,
+  // see `DvG_Script.h`. Resolves to the status afterwards, which holds the
+  // full length when all frames arrived. Throws like `sendFrame()`.
+  std::future<TC_ScriptStatus> uploadScript(const TC_Script &script);
+
+  // Start or stop the script, resolving to the status afterwards
+  std::future<TC_ScriptStatus> runScript();
+  std::future<TC_ScriptStatus> stopScript();
+  std::future<TC_ScriptStatus> scriptStatus();
+
+  // Oscillate at +/-`rev_per_sec`, reversing every half `period_ms`, which
+  // replaces the script. 0 for either stops oscillating.
+  std::future<TC_ScriptStatus> oscillate(float rev_per_sec, float period_ms);
+
+  // Send a binary frame. Frames are not answered, so there is nothing to
+  // wait for. Throws `std::invalid_argument` when the payload exceeds
+  // `DVG_FRAME_PAYLOAD` and `std::runtime_error` when writing fails.
+  void sendFrame(const TC_FramePayload &payload);
+
+private:
+  struct Pending {
+    std::function<void(const std::string &)> on_reply;
+    std::function<void(std::exception_ptr)> on_error;
+  };
+
+  template <typename T>
+  std::future<T> submit(const std::string &cmd,
+                        std::function<T(const std::string &)> parse);
+
+  void readerLoop();
+  void dispatchLine(const std::string &line);
+  void dispatchFrame(std::string &frame);
+  void failAllPending(const char *reason);
+
+  std::string _port;
+  int _baudrate;
+  int _fd = -1;
+  int _wake_pipe[2] = {-1, -1}; // Wakes the reader thread on `close()`
+  std::thread _reader;
+
+  std::mutex _mutex; // Guards `_pending`, the callbacks, `_telem_dec` and
+                     // port writes
+  std::deque<Pending> _pending;
+  std::function<void(const std::string &)> _unsolicited;
+  std::function<void(const DvG_TelemetryRecord &)> _telemetry;
+  DvG_TelemetryDecoder _telem_dec;
+};
+
+#endif
@@ -0,0 +1,62 @@
+/*
+TC_FirmwareModel.h
+
+The firmware itself, `setup()` and `loop()` of `src_mcu/src/main.cpp` built
+for the host, running on the virtual board of `TC_Board.h`. Commands take the
+same path as on the device: `DvG_SerialCommand`, the command table of
+`DvG_CommandRegistry`, `DvG_Script`, `DvG_CommandQueue` and the replies
+through `DvG_TxQueue`. Driven by `TC_Simulator` and the soak test, without
+any I/O of its own.
+
+The firmware lives in globals, just like on the device, so there can only be
+one model per process.
+*/
+
+#ifndef TC_FirmwareModel_h
+#define TC_FirmwareModel_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Virtual time taken by one pass of `loop()` [us], by default. Tasks run in no
+// time on the virtual clock, so this only sets the polling grain of the
+// stepper.
+#define TC_LOOP_US 10
+
+class TC_FirmwareModel {
+public:
+  // Runs `loop()` once every `loop_us` [us] of virtual time. Throws
+  // `std::logic_error` when another model exists.
+  explicit TC_FirmwareModel(uint32_t loop_us = TC_LOOP_US);
+  ~TC_FirmwareModel();
+
+  TC_FirmwareModel(const TC_FirmwareModel &) = delete;
+  TC_FirmwareModel &operator=(const TC_FirmwareModel &) = delete;
+
+  // Run `setup()` once and return its output
+  std::string boot();
+
+  // Bytes arriving on the programming port, handled by the next passes of
+  // `loop()`
+  void receive(const char *data, size_t len);
+
+  // Advance the virtual clock by `dt` seconds, running `loop()` once every
+  // `loop_us`. Returns everything the firmware sent on the programming port
+  // in that period: replies, latency reports and telemetry frames.
+  std::string advance(double dt);
+
+  // Advance the virtual clock by a single `loop_us` and run `loop()` once.
+  // Returns the output like `advance()`.
+  std::string runLoop();
+
+  // Virtual `micros64()`
+  uint64_t micros64() const;
+
+private:
+  uint32_t _loop_us; // [us]
+  bool _fBooted = false;
+  double _t_frac_us = 0.0; // Not yet run part of `advance()`
+};
+
+#endif
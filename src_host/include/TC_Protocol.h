@@ -0,0 +1,205 @@
+/*
+TC_Protocol.h
+
+Host-side description of the serial protocol spoken by the firmware in
+`src_mcu/src/main.cpp`. Commands are short ASCII strings terminated by a
+linefeed. Most commands are answered by one line of text, the table below
+lists the exceptions: the statistics commands send their statistics lines
+first and close with one fixed line, a time-tagged command '@' gets answered
+right away and its command's own reply follows later as an "at ..." line,
+and 'telem' starts a stream of binary frames. Replies are queued by the
+firmware and only dropped, oldest first, when the host does not keep up
+reading, see `DvG_TxQueue.h`.
+
+The firmware listens on both its programming port at 115200 baud and its
+native USB port, which is not limited by a baud rate. Each port has its own
+reply queue: replies go back to the port the command came in on, and 'bin',
+'tx' and 'telem' act on that port alone. Stream telemetry over the native
+USB port to leave the programming port free.
+
+  ?       Identify                    "Mini Taylor-Couette demo Pfister"
+  =, -    Brightness up / down        "brightness: 60"
+  w, g    Toggle white / green        "Only white: 1"
+  f<num>  Set speed [rev per sec]     "f = 2.33 Hz, 466.00 steps/s, SINGLE"
+  ,  .    Nudge speed by 0.05 rev/s   (speed reply)
+  1 - 4   Set stepping style          (speed reply)
+  lat     Toggle latency reports      "Latency report: 1"
+  strobe<num>
+          Strobe once per rev at      "Strobe: 90.00 deg"
+          angle [deg], none: off      or "Strobe: off"
+          During 'osc' once per period at that phase of it
+  bin     Print and reset frame       "bin ..." line, then "Frame counters reset"
+          counters
+  prof    Print and reset profiler    "prof ..." lines, then "Profiler reset"
+                                      or "Profiler disabled"
+  leds    Print and reset LED frames  "leds ..." lines, then "LED counters reset"
+  sched   Print and reset scheduler   "sched ..." lines, then "Scheduler reset"
+  cmds    Print and reset command     "cmd ..." lines, then
+          counters                    "Command counters reset"
+  tx      Print and reset reply       "tx ..." line, then "TX counters reset"
+          queue counters
+  telem<num>
+          Stream telemetry every      "Telemetry: 100 ms"
+          <num> ms, none: off         or "Telemetry: off"
+  script  Print script status         "Script: idle 42 bytes pc 0"
+  script run, script stop, script clear
+          Control the script          (script reply)
+  osc <speed> <period>
+          Oscillate at +/-<speed>     (script reply)
+          [rev per sec], reversing
+          every half <period> [ms]
+  clock   Device clock [us], 64-bit   "clock 123456789"
+  @<t> <cmd>
+          Execute <cmd> at device     "Queued @<t>", or "Queue full",
+          clock <t> [us]              "Command too long" or
+                                      "Bad timed command". Once executed,
+                                      "at <t> <t_applied> <reply>"
+  r       Toggle motor on/off         "Run" or "Release"
+  other   Unknown command             "Unknown command"
+
+Some lines are sent by the firmware on its own and never answer a command:
+
+  "lat <t_rx> <t_dispatch> <t_step>"  Latency report of a speed change
+  "prof ..."                          Profiler statistics, see 'prof'
+  "sched ..."                         Scheduler statistics, see 'sched'
+  "leds ..."                          LED frame statistics, see 'leds'
+  "bin ..."                           Binary frame counters, see 'bin'
+  "cmd ..."                           Command statistics, see 'cmds'
+  "tx ..."                            Reply queue counters, see 'tx'
+  "at <t> <t_applied> <reply>"        Reply of a time-tagged command
+
+Binary frames, see `DvG_BinaryFrame.h`, can be mixed with the commands. Their
+payload is a sequence of operations, each an opcode byte followed by its
+little-endian argument, see `TC_FrameOp`. Frames are never answered.
+
+Experiment scripts, see `DvG_Script.h` and `TC_Script`, are uploaded by
+SCRIPT operations in binary frames and then started by 'script run'.
+
+The other way around, the firmware sends its telemetry records as binary
+frames in between the lines, see `DvG_Telemetry.h` and 'telem'.
+*/
+
+#ifndef TC_Protocol_h
+#define TC_Protocol_h
+
+#include <cstdint>
+#include <string>
+
+// Maximum length of a command including the '\0' terminator, must match
+// `CMD_LEN` in main.cpp.
+#define TC_STR_LEN 64
+
+// Stepping styles, values match `SINGLE`, `DOUBLE`, etc. of
+// `Adafruit_MotorShield.h` and the '1' to '4' commands.
+enum class TC_Style : uint8_t {
+  SINGLE = 1,
+  DOUBLE = 2,
+  INTERLEAVE = 3,
+  MICROSTEP = 4
+};
+
+// Operations of a binary frame, values match `FRAME_OP_...` in main.cpp
+enum class TC_FrameOp : uint8_t {
+  SPEED = 0x01,      // float32 [rev per sec]
+  STYLE = 0x02,      // uint8, `TC_Style`
+  BRIGHTNESS = 0x03, // uint8
+  RUN = 0x04,        // uint8 0: release, 1: run
+  SCRIPT = 0x05      // uint16 offset, uint8 n, n bytes of script
+};
+
+// Payload of a binary frame, built by appending operations
+class TC_FramePayload {
+public:
+  TC_FramePayload &speed(float rev_per_sec);
+  TC_FramePayload &style(TC_Style style);
+  TC_FramePayload &brightness(uint8_t value);
+  TC_FramePayload &run(bool on);
+  TC_FramePayload &script(uint16_t offset, const std::string &bytes);
+
+  const std::string &bytes() const { return _bytes; }
+
+  // Complete frame on the wire, delimiters included
+  std::string encode() const;
+
+private:
+  std::string _bytes;
+};
+
+// Bytecode of an experiment script, built by appending operations, see
+// `DvG_Script.h`. Speeds are rounded to the fixed point of the firmware.
+class TC_Script {
+public:
+  TC_Script &speed(double rev_per_sec);
+  TC_Script &style(TC_Style style);
+  TC_Script &run(bool on);
+  TC_Script &wait(uint32_t us);
+  TC_Script &sweep(double rev_per_sec, uint32_t us);
+  TC_Script &loop(uint16_t count); // 0: forever
+  TC_Script &next();
+  TC_Script &led(uint32_t color, uint16_t fade_ms);
+  TC_Script &ledOff(uint16_t fade_ms);
+  TC_Script &end();
+
+  const std::string &bytes() const { return _bytes; }
+
+private:
+  void put16(uint16_t value);
+  void put32(uint32_t value);
+
+  std::string _bytes;
+};
+
+// Values match `DvG_ScriptState`
+enum class TC_ScriptState : uint8_t { IDLE, RUNNING, DONE, INVALID };
+
+// Decoded reply of 'script'
+struct TC_ScriptStatus {
+  TC_ScriptState state = TC_ScriptState::IDLE;
+  uint16_t length = 0; // [bytes]
+  uint16_t pc = 0;     // Current operation, or the offending one when invalid
+};
+
+// Decoded reply of a time-tagged command, see '@'
+struct TC_Timed {
+  uint64_t t = 0;         // [us] Requested device time
+  uint64_t t_applied = 0; // [us] Step boundary nearest to `t`
+  std::string reply;      // Reply of the command itself
+};
+
+// Decoded reply of `printSpeed()`
+struct TC_SpeedState {
+  float speed = 0.0f;         // [rev per sec]
+  float steps_per_sec = 0.0f; // [steps per sec]
+  TC_Style style = TC_Style::SINGLE;
+};
+
+// Decoded latency report, timestamps are `micros()` of the device
+struct TC_Latency {
+  uint32_t t_rx = 0;       // Linefeed received
+  uint32_t t_dispatch = 0; // Command handled
+  uint32_t t_step = 0;     // First step at the new interval
+
+  uint32_t rxToDispatch() const { return t_dispatch - t_rx; }
+  uint32_t rxToStep() const { return t_step - t_rx; }
+};
+
+const char *styleName(TC_Style style);
+
+// Format a number exactly like Arduino's `Print::print(double, digits)`
+std::string formatArduinoFloat(double value, int digits = 2);
+
+// Reply parsers. Return false when `line` is not of the expected form.
+bool parseSpeedReply(const std::string &line, TC_SpeedState &out);
+bool parseBrightnessReply(const std::string &line, uint8_t &out);
+bool parseFlagReply(const std::string &line, const std::string &prefix,
+                    bool &out);
+bool parseLatencyReport(const std::string &line, TC_Latency &out);
+bool parseTelemetryReply(const std::string &line, uint32_t &period_ms);
+bool parseScriptReply(const std::string &line, TC_ScriptStatus &out);
+bool parseClockReply(const std::string &line, uint64_t &t_us);
+bool parseTimedReport(const std::string &line, TC_Timed &out);
+
+// True for lines the firmware sends on its own accord
+bool isAsyncLine(const std::string &line);
+
+#endif
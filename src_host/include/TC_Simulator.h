@@ -0,0 +1,53 @@
+/*
+TC_Simulator.h
+
+Runs `TC_FirmwareModel` behind a Linux pseudo-terminal, so that
+`TC_Controller`, terminal programs and experiment scripts can talk to
+"the device" at full speed without any hardware attached. Open the path
+returned by `portName()` like any other serial port.
+
+The pseudo-terminal is the programming port of the board: its bytes go
+straight to the firmware, which assembles its commands and binary frames
+itself. The virtual clock follows the wall clock.
+*/
+
+#ifndef TC_Simulator_h
+#define TC_Simulator_h
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "TC_FirmwareModel.h"
+
+class TC_Simulator {
+public:
+  TC_Simulator();
+  ~TC_Simulator();
+
+  TC_Simulator(const TC_Simulator &) = delete;
+  TC_Simulator &operator=(const TC_Simulator &) = delete;
+
+  // Create the pseudo-terminal, emit the boot message and start serving.
+  // Throws `std::runtime_error`.
+  void start();
+  void stop();
+
+  // Path of the slave side of the pseudo-terminal, e.g. "/dev/pts/3"
+  const std::string &portName() const { return _port_name; }
+
+private:
+  void serveLoop();
+  void writeAll(const std::string &data);
+
+  int _master_fd = -1;
+  int _slave_fd = -1; // Kept open, so the master survives client reconnects
+  int _wake_pipe[2] = {-1, -1};
+  std::string _port_name;
+  std::thread _thread;
+
+  TC_FirmwareModel _model; // Only used by the serving thread once started
+  std::chrono::steady_clock::time_point _t_last;
+};
+
+#endif
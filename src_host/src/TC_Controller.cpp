@@ -0,0 +1,477 @@
+#include "TC_Controller.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "DvG_BinaryFrame.h"
+
+// Longest frame without its delimiters
+#define TC_FRAME_ENCODED_MAX (DVG_FRAME_ENCODED(DVG_FRAME_PAYLOAD) - 2)
+
+static speed_t toTermiosBaud(int baudrate) {
+  switch (baudrate) {
+    case 9600:
+      return B9600;
+    case 19200:
+      return B19200;
+    case 38400:
+      return B38400;
+    case 57600:
+      return B57600;
+    case 115200:
+      return B115200;
+    case 230400:
+      return B230400;
+    case 460800:
+      return B460800;
+    case 921600:
+      return B921600;
+    default:
+      throw std::invalid_argument("Unsupported baudrate");
+  }
+}
+
+// Write all of `data`, retrying on interrupts. Returns false with `errno` set
+// on failure.
+static bool writeAll(int fd, const std::string &data) {
+  const char *p = data.data();
+  size_t left = data.size();
+  while (left > 0) {
+    ssize_t n = write(fd, p, left);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    p += n;
+    left -= (size_t)n;
+  }
+  return true;
+}
+
+TC_Controller::TC_Controller(const std::string &port, int baudrate)
+    : _port(port), _baudrate(baudrate) {}
+
+TC_Controller::~TC_Controller() { close(); }
+
+void TC_Controller::open() {
+  if (_fd >= 0) {
+    return;
+  }
+
+  int fd = ::open(_port.c_str(), O_RDWR | O_NOCTTY);
+  if (fd < 0) {
+    throw std::runtime_error("Cannot open " + _port + ": " +
+                             std::strerror(errno));
+  }
+
+  struct termios tio;
+  if (tcgetattr(fd, &tio) == 0) {
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, toTermiosBaud(_baudrate));
+    cfsetospeed(&tio, toTermiosBaud(_baudrate));
+    tio.c_cflag |= CLOCAL | CREAD;
+    tcsetattr(fd, TCSANOW, &tio);
+  }
+
+  // Discard stale output, like the boot message, which would otherwise be
+  // mistaken for the reply to our first request
+  tcflush(fd, TCIFLUSH);
+
+  if (pipe(_wake_pipe) != 0) {
+    ::close(fd);
+    throw std::runtime_error("Cannot create wake-up pipe");
+  }
+
+  _fd = fd;
+  _reader = std::thread(&TC_Controller::readerLoop, this);
+}
+
+void TC_Controller::close() {
+  if (_fd < 0) {
+    return;
+  }
+
+  char c = 0;
+  if (write(_wake_pipe[1], &c, 1) < 0) {
+    // Reader thread will still notice the closed port
+  }
+  if (_reader.joinable()) {
+    _reader.join();
+  }
+
+  ::close(_wake_pipe[0]);
+  ::close(_wake_pipe[1]);
+  _wake_pipe[0] = _wake_pipe[1] = -1;
+  ::close(_fd);
+  _fd = -1;
+
+  failAllPending("Port closed");
+}
+
+void TC_Controller::setUnsolicitedCallback(
+    std::function<void(const std::string &)> cb) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _unsolicited = std::move(cb);
+}
+
+void TC_Controller::setTelemetryCallback(
+    std::function<void(const DvG_TelemetryRecord &)> cb) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _telemetry = std::move(cb);
+}
+
+uint32_t TC_Controller::telemetryGaps() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _telem_dec.gaps();
+}
+
+/*------------------------------------------------------------------------------
+    Requests
+------------------------------------------------------------------------------*/
+
+template <typename T>
+std::future<T> TC_Controller::submit(
+    const std::string &cmd, std::function<T(const std::string &)> parse) {
+  auto promise = std::make_shared<std::promise<T>>();
+  std::future<T> future = promise->get_future();
+
+  if (cmd.size() >= TC_STR_LEN) {
+    promise->set_exception(std::make_exception_ptr(
+        std::invalid_argument("Command exceeds firmware buffer: " + cmd)));
+    return future;
+  }
+
+  Pending pending;
+  pending.on_reply = [promise, parse](const std::string &line) {
+    try {
+      promise->set_value(parse(line));
+    } catch (...) {
+      promise->set_exception(std::current_exception());
+    }
+  };
+  pending.on_error = [promise](std::exception_ptr e) {
+    promise->set_exception(e);
+  };
+
+  // Queue and write under the same lock, so that the order of `_pending`
+  // always equals the order of the commands on the wire
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_fd < 0) {
+    pending.on_error(
+        std::make_exception_ptr(std::runtime_error("Port not open")));
+    return future;
+  }
+
+  if (!writeAll(_fd, cmd + "\n")) {
+    pending.on_error(std::make_exception_ptr(std::runtime_error(
+        std::string("Write failed: ") + std::strerror(errno))));
+    return future;
+  }
+  _pending.push_back(std::move(pending));
+  return future;
+}
+
+void TC_Controller::sendFrame(const TC_FramePayload &payload) {
+  if (payload.bytes().size() > DVG_FRAME_PAYLOAD) {
+    throw std::invalid_argument("Frame payload too long");
+  }
+  std::string frame = payload.encode();
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_fd < 0) {
+    throw std::runtime_error("Port not open");
+  }
+  if (!writeAll(_fd, frame)) {
+    throw std::runtime_error(std::string("Write failed: ") +
+                             std::strerror(errno));
+  }
+}
+
+static TC_SpeedState expectSpeed(const std::string &line) {
+  TC_SpeedState state;
+  if (!parseSpeedReply(line, state)) {
+    throw std::runtime_error("Unexpected reply: " + line);
+  }
+  return state;
+}
+
+static uint8_t expectBrightness(const std::string &line) {
+  uint8_t value;
+  if (!parseBrightnessReply(line, value)) {
+    throw std::runtime_error("Unexpected reply: " + line);
+  }
+  return value;
+}
+
+static bool expectFlag(const std::string &line, const char *prefix) {
+  bool value;
+  if (!parseFlagReply(line, prefix, value)) {
+    throw std::runtime_error("Unexpected reply: " + line);
+  }
+  return value;
+}
+
+std::future<std::string> TC_Controller::query(const std::string &cmd) {
+  return submit<std::string>(cmd, [](const std::string &line) { return line; });
+}
+
+std::future<std::string> TC_Controller::identify() { return query("?"); }
+
+std::future<uint8_t> TC_Controller::brightnessUp() {
+  return submit<uint8_t>("=", expectBrightness);
+}
+
+std::future<uint8_t> TC_Controller::brightnessDown() {
+  return submit<uint8_t>("-", expectBrightness);
+}
+
+std::future<bool> TC_Controller::toggleWhite() {
+  return submit<bool>("w", [](const std::string &line) {
+    return expectFlag(line, "Only white: ");
+  });
+}
+
+std::future<bool> TC_Controller::toggleGreen() {
+  return submit<bool>("g", [](const std::string &line) {
+    return expectFlag(line, "Only green: ");
+  });
+}
+
+std::future<TC_SpeedState> TC_Controller::setSpeed(float rev_per_sec) {
+  char cmd[TC_STR_LEN];
+  std::snprintf(cmd, sizeof(cmd), "f%.6g", rev_per_sec);
+  return submit<TC_SpeedState>(cmd, expectSpeed);
+}
+
+std::future<TC_SpeedState> TC_Controller::nudgeSlower() {
+  return submit<TC_SpeedState>(",", expectSpeed);
+}
+
+std::future<TC_SpeedState> TC_Controller::nudgeFaster() {
+  return submit<TC_SpeedState>(".", expectSpeed);
+}
+
+std::future<TC_SpeedState> TC_Controller::setStyle(TC_Style style) {
+  return submit<TC_SpeedState>(std::to_string((int)style), expectSpeed);
+}
+
+std::future<bool> TC_Controller::toggleRun() {
+  return submit<bool>("r", [](const std::string &line) {
+    if (line == "Run") {
+      return true;
+    } else if (line == "Release") {
+      return false;
+    }
+    throw std::runtime_error("Unexpected reply: " + line);
+  });
+}
+
+std::future<bool> TC_Controller::toggleLatencyReport() {
+  return submit<bool>("lat", [](const std::string &line) {
+    return expectFlag(line, "Latency report: ");
+  });
+}
+
+std::future<uint32_t> TC_Controller::setTelemetry(uint32_t period_ms) {
+  std::string cmd = "telem";
+  if (period_ms) {
+    cmd += std::to_string(period_ms);
+  }
+  return submit<uint32_t>(cmd, [](const std::string &line) {
+    uint32_t value;
+    if (!parseTelemetryReply(line, value)) {
+      throw std::runtime_error("Unexpected reply: " + line);
+    }
+    return value;
+  });
+}
+
+std::future<uint64_t> TC_Controller::clock() {
+  return submit<uint64_t>("clock", [](const std::string &line) {
+    uint64_t value;
+    if (!parseClockReply(line, value)) {
+      throw std::runtime_error("Unexpected reply: " + line);
+    }
+    return value;
+  });
+}
+
+std::future<bool> TC_Controller::at(uint64_t t_us, const std::string &cmd) {
+  std::string tag = "@" + std::to_string(t_us);
+  return submit<bool>(tag + " " + cmd, [tag](const std::string &line) {
+    if (line == "Queued " + tag) {
+      return true;
+    } else if (line == "Queue full" || line == "Command too long" ||
+               line == "Bad timed command") {
+      return false;
+    }
+    throw std::runtime_error("Unexpected reply: " + line);
+  });
+}
+
+static TC_ScriptStatus expectScript(const std::string &line) {
+  TC_ScriptStatus status;
+  if (!parseScriptReply(line, status)) {
+    throw std::runtime_error("Unexpected reply: " + line);
+  }
+  return status;
+}
+
+std::future<TC_ScriptStatus>
+TC_Controller::uploadScript(const TC_Script &script) {
+  // Room for the opcode, offset and count of the SCRIPT operation
+  const size_t chunk = DVG_FRAME_PAYLOAD - 4;
+  const std::string &bytes = script.bytes();
+
+  submit<TC_ScriptStatus>("script clear", expectScript);
+  for (size_t offset = 0; offset < bytes.size(); offset += chunk) {
+    sendFrame(TC_FramePayload().script((uint16_t)offset,
+                                       bytes.substr(offset, chunk)));
+  }
+  return scriptStatus();
+}
+
+std::future<TC_ScriptStatus> TC_Controller::runScript() {
+  return submit<TC_ScriptStatus>("script run", expectScript);
+}
+
+std::future<TC_ScriptStatus> TC_Controller::stopScript() {
+  return submit<TC_ScriptStatus>("script stop", expectScript);
+}
+
+std::future<TC_ScriptStatus> TC_Controller::scriptStatus() {
+  return submit<TC_ScriptStatus>("script", expectScript);
+}
+
+std::future<TC_ScriptStatus> TC_Controller::oscillate(float rev_per_sec,
+                                                      float period_ms) {
+  char cmd[TC_STR_LEN];
+  std::snprintf(cmd, sizeof(cmd), "osc %.6g %.6g", rev_per_sec, period_ms);
+  return submit<TC_ScriptStatus>(cmd, expectScript);
+}
+
+/*------------------------------------------------------------------------------
+    Reader thread
+------------------------------------------------------------------------------*/
+
+void TC_Controller::readerLoop() {
+  std::string line;
+  std::string frame;
+  bool fBinary = false; // Inside a binary frame
+  char buf[256];
+
+  for (;;) {
+    struct pollfd fds[2] = {{_fd, POLLIN, 0}, {_wake_pipe[0], POLLIN, 0}};
+    if (poll(fds, 2, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    if (fds[1].revents) {
+      break; // `close()` requested
+    }
+    if (fds[0].revents & (POLLERR | POLLNVAL)) {
+      break;
+    }
+
+    ssize_t n = read(_fd, buf, sizeof(buf));
+    if (n <= 0) {
+      if (n < 0 && (errno == EINTR || errno == EAGAIN)) {
+        continue;
+      }
+      break; // Device went away
+    }
+
+    for (ssize_t i = 0; i < n; ++i) {
+      char c = buf[i];
+      if (fBinary) {
+        if (c != 0) {
+          if (frame.size() <= TC_FRAME_ENCODED_MAX) {
+            frame += c; // Longer ones fail in `dispatchFrame()`
+          }
+        } else if (!frame.empty()) {
+          dispatchFrame(frame);
+          frame.clear();
+          fBinary = false;
+        }
+      } else if (c == 0) {
+        fBinary = true;
+      } else if (c == '\r') {
+        continue;
+      } else if (c == '\n') {
+        dispatchLine(line);
+        line.clear();
+      } else {
+        line += c;
+      }
+    }
+  }
+
+  failAllPending("Connection lost");
+}
+
+void TC_Controller::dispatchLine(const std::string &line) {
+  Pending pending;
+  std::function<void(const std::string &)> unsolicited;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_pending.empty() || isAsyncLine(line)) {
+      unsolicited = _unsolicited;
+    } else {
+      pending = std::move(_pending.front());
+      _pending.pop_front();
+    }
+  }
+
+  // Invoke outside of the lock, callbacks may issue new requests
+  if (pending.on_reply) {
+    pending.on_reply(line);
+  } else if (unsolicited) {
+    unsolicited(line);
+  }
+}
+
+void TC_Controller::dispatchFrame(std::string &frame) {
+  DvG_TelemetryRecord rec;
+  std::function<void(const DvG_TelemetryRecord &)> telemetry;
+  if (frame.size() > TC_FRAME_ENCODED_MAX) {
+    return;
+  }
+  int16_t len = dvgFrameDecode((uint8_t *)&frame[0], (uint16_t)frame.size());
+  if (len < 0 || len > DVG_FRAME_PAYLOAD) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_telem_dec.decode((const uint8_t *)frame.data(), (uint8_t)len, rec)) {
+      return;
+    }
+    telemetry = _telemetry;
+  }
+
+  // Invoke outside of the lock, like `dispatchLine()`
+  if (telemetry) {
+    telemetry(rec);
+  }
+}
+
+void TC_Controller::failAllPending(const char *reason) {
+  std::deque<Pending> pending;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    pending.swap(_pending);
+  }
+  for (auto &p : pending) {
+    p.on_error(std::make_exception_ptr(std::runtime_error(reason)));
+  }
+}
@@ -0,0 +1,54 @@
+#include "TC_FirmwareModel.h"
+
+#include <stdexcept>
+
+#include "TC_Board.h"
+
+// `src_mcu/src/main.cpp`
+void setup();
+void loop();
+
+static bool fModelExists = false;
+
+TC_FirmwareModel::TC_FirmwareModel(uint32_t loop_us) : _loop_us(loop_us) {
+  if (fModelExists) {
+    throw std::logic_error("Only one TC_FirmwareModel per process");
+  }
+  fModelExists = true;
+}
+
+TC_FirmwareModel::~TC_FirmwareModel() { fModelExists = false; }
+
+std::string TC_FirmwareModel::boot() {
+  if (!_fBooted) {
+    _fBooted = true;
+    setup();
+    loop(); // Sends what `setup()` queued up
+  }
+  TC_Board::takeSent(TC_Board::PORT_USB); // No terminal on the native USB port
+  return TC_Board::takeSent(TC_Board::PORT_SERIAL);
+}
+
+void TC_FirmwareModel::receive(const char *data, size_t len) {
+  TC_Board::receive(TC_Board::PORT_SERIAL, data, len);
+}
+
+std::string TC_FirmwareModel::advance(double dt) {
+  _t_frac_us += dt * 1e6;
+  while (_t_frac_us >= _loop_us) {
+    _t_frac_us -= _loop_us;
+    TC_Board::advance(_loop_us);
+    loop();
+  }
+  TC_Board::takeSent(TC_Board::PORT_USB);
+  return TC_Board::takeSent(TC_Board::PORT_SERIAL);
+}
+
+std::string TC_FirmwareModel::runLoop() {
+  TC_Board::advance(_loop_us);
+  loop();
+  TC_Board::takeSent(TC_Board::PORT_USB);
+  return TC_Board::takeSent(TC_Board::PORT_SERIAL);
+}
+
+uint64_t TC_FirmwareModel::micros64() const { return TC_Board::time(); }
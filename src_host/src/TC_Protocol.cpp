@@ -0,0 +1,337 @@
+#include "TC_Protocol.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "DvG_BinaryFrame.h"
+
+const char *styleName(TC_Style style) {
+  switch (style) {
+    case TC_Style::SINGLE:
+      return "SINGLE";
+    case TC_Style::DOUBLE:
+      return "DOUBLE";
+    case TC_Style::INTERLEAVE:
+      return "INTERLEAVE";
+    case TC_Style::MICROSTEP:
+      return "MICROSTEP";
+  }
+  return "";
+}
+
+std::string formatArduinoFloat(double number, int digits) {
+  // Mirrors `Print::printFloat()` of the Arduino core, including its rounding
+  // and overflow behaviour, so that the simulator replies byte-identically.
+  if (std::isnan(number)) {
+    return "nan";
+  }
+  if (std::isinf(number)) {
+    return "inf";
+  }
+  if (number > 4294967040.0 || number < -4294967040.0) {
+    return "ovf";
+  }
+
+  std::string str;
+  if (number < 0.0) {
+    str += '-';
+    number = -number;
+  }
+
+  double rounding = 0.5;
+  for (int i = 0; i < digits; ++i) {
+    rounding /= 10.0;
+  }
+  number += rounding;
+
+  unsigned long int_part = (unsigned long)number;
+  double remainder = number - (double)int_part;
+  str += std::to_string(int_part);
+  if (digits > 0) {
+    str += '.';
+  }
+  while (digits-- > 0) {
+    remainder *= 10.0;
+    unsigned int to_print = (unsigned int)remainder;
+    str += std::to_string(to_print);
+    remainder -= to_print;
+  }
+  return str;
+}
+
+bool parseSpeedReply(const std::string &line, TC_SpeedState &out) {
+  // "f = 2.33 Hz, 466.00 steps/s, SINGLE"
+  float speed, steps_per_sec;
+  char style[16];
+  if (std::sscanf(line.c_str(), "f = %f Hz, %f steps/s, %15s", &speed,
+                  &steps_per_sec, style) != 3) {
+    return false;
+  }
+
+  if (std::strcmp(style, "SINGLE") == 0) {
+    out.style = TC_Style::SINGLE;
+  } else if (std::strcmp(style, "DOUBLE") == 0) {
+    out.style = TC_Style::DOUBLE;
+  } else if (std::strcmp(style, "INTERLEAVE") == 0) {
+    out.style = TC_Style::INTERLEAVE;
+  } else if (std::strcmp(style, "MICROSTEP") == 0) {
+    out.style = TC_Style::MICROSTEP;
+  } else {
+    return false;
+  }
+  out.speed = speed;
+  out.steps_per_sec = steps_per_sec;
+  return true;
+}
+
+bool parseBrightnessReply(const std::string &line, uint8_t &out) {
+  unsigned int value;
+  if (std::sscanf(line.c_str(), "brightness: %u", &value) != 1 ||
+      value > 255) {
+    return false;
+  }
+  out = (uint8_t)value;
+  return true;
+}
+
+bool parseFlagReply(const std::string &line, const std::string &prefix,
+                    bool &out) {
+  if (line.compare(0, prefix.size(), prefix) != 0) {
+    return false;
+  }
+  const char *value = line.c_str() + prefix.size();
+  if (std::strcmp(value, "0") == 0) {
+    out = false;
+  } else if (std::strcmp(value, "1") == 0) {
+    out = true;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool parseLatencyReport(const std::string &line, TC_Latency &out) {
+  unsigned long t_rx, t_dispatch, t_step;
+  if (std::sscanf(line.c_str(), "lat %lu %lu %lu", &t_rx, &t_dispatch,
+                  &t_step) != 3) {
+    return false;
+  }
+  out.t_rx = (uint32_t)t_rx;
+  out.t_dispatch = (uint32_t)t_dispatch;
+  out.t_step = (uint32_t)t_step;
+  return true;
+}
+
+bool parseTelemetryReply(const std::string &line, uint32_t &period_ms) {
+  unsigned long value;
+  char unit[3];
+  if (line == "Telemetry: off") {
+    period_ms = 0;
+    return true;
+  }
+  if (std::sscanf(line.c_str(), "Telemetry: %lu %2s", &value, unit) != 2 ||
+      std::strcmp(unit, "ms") != 0) {
+    return false;
+  }
+  period_ms = (uint32_t)value;
+  return true;
+}
+
+bool parseScriptReply(const std::string &line, TC_ScriptStatus &out) {
+  // "Script: running 42 bytes pc 17"
+  char state[8];
+  unsigned int length, pc;
+  if (std::sscanf(line.c_str(), "Script: %7s %u bytes pc %u", state, &length,
+                  &pc) != 3) {
+    return false;
+  }
+
+  if (std::strcmp(state, "idle") == 0) {
+    out.state = TC_ScriptState::IDLE;
+  } else if (std::strcmp(state, "running") == 0) {
+    out.state = TC_ScriptState::RUNNING;
+  } else if (std::strcmp(state, "done") == 0) {
+    out.state = TC_ScriptState::DONE;
+  } else if (std::strcmp(state, "invalid") == 0) {
+    out.state = TC_ScriptState::INVALID;
+  } else {
+    return false;
+  }
+  out.length = (uint16_t)length;
+  out.pc = (uint16_t)pc;
+  return true;
+}
+
+bool parseClockReply(const std::string &line, uint64_t &t_us) {
+  unsigned long long value;
+  int n = 0;
+  if (std::sscanf(line.c_str(), "clock %llu%n", &value, &n) != 1 ||
+      (size_t)n != line.size()) {
+    return false;
+  }
+  t_us = value;
+  return true;
+}
+
+bool parseTimedReport(const std::string &line, TC_Timed &out) {
+  unsigned long long t, t_applied;
+  int n = 0;
+  if (std::sscanf(line.c_str(), "at %llu %llu %n", &t, &t_applied, &n) != 2 ||
+      n == 0) {
+    return false;
+  }
+  out.t = t;
+  out.t_applied = t_applied;
+  out.reply = line.substr(n);
+  return true;
+}
+
+bool isAsyncLine(const std::string &line) {
+  return (line.compare(0, 4, "lat ") == 0 ||
+          line.compare(0, 5, "prof ") == 0 ||
+          line.compare(0, 6, "sched ") == 0 ||
+          line.compare(0, 5, "leds ") == 0 ||
+          line.compare(0, 4, "bin ") == 0 ||
+          line.compare(0, 4, "cmd ") == 0 ||
+          line.compare(0, 3, "tx ") == 0 ||
+          line.compare(0, 3, "at ") == 0);
+}
+
+TC_FramePayload &TC_FramePayload::speed(float rev_per_sec) {
+  char raw[4];
+  std::memcpy(raw, &rev_per_sec, 4); // Little-endian, like the SAMD21
+  _bytes += (char)TC_FrameOp::SPEED;
+  _bytes.append(raw, 4);
+  return *this;
+}
+
+TC_FramePayload &TC_FramePayload::style(TC_Style style) {
+  _bytes += (char)TC_FrameOp::STYLE;
+  _bytes += (char)style;
+  return *this;
+}
+
+TC_FramePayload &TC_FramePayload::brightness(uint8_t value) {
+  _bytes += (char)TC_FrameOp::BRIGHTNESS;
+  _bytes += (char)value;
+  return *this;
+}
+
+TC_FramePayload &TC_FramePayload::run(bool on) {
+  _bytes += (char)TC_FrameOp::RUN;
+  _bytes += (char)on;
+  return *this;
+}
+
+TC_FramePayload &TC_FramePayload::script(uint16_t offset,
+                                         const std::string &bytes) {
+  _bytes += (char)TC_FrameOp::SCRIPT;
+  _bytes += (char)(offset & 0xFF);
+  _bytes += (char)(offset >> 8);
+  _bytes += (char)bytes.size();
+  _bytes += bytes;
+  return *this;
+}
+
+std::string TC_FramePayload::encode() const {
+  std::string frame(DVG_FRAME_ENCODED(_bytes.size()), '\0');
+  uint16_t len = dvgFrameEncode((const uint8_t *)_bytes.data(),
+                                (uint16_t)_bytes.size(), (uint8_t *)&frame[0]);
+  frame.resize(len);
+  return frame;
+}
+
+/*------------------------------------------------------------------------------
+    TC_Script
+------------------------------------------------------------------------------*/
+
+// Opcodes, values match `DvG_ScriptOp`
+enum : uint8_t {
+  OP_END = 0x00,
+  OP_SPEED = 0x01,
+  OP_STYLE = 0x02,
+  OP_RUN = 0x03,
+  OP_WAIT = 0x04,
+  OP_SWEEP = 0x05,
+  OP_LOOP = 0x06,
+  OP_NEXT = 0x07,
+  OP_LED = 0x08,
+  OP_LED_OFF = 0x09
+};
+
+// [urev per sec], `STEPPER_SPEED_ONE`
+static uint32_t fixedSpeed(double rev_per_sec) {
+  return (uint32_t)(int32_t)std::lround(rev_per_sec * 1e6);
+}
+
+void TC_Script::put16(uint16_t value) {
+  _bytes += (char)(value & 0xFF);
+  _bytes += (char)(value >> 8);
+}
+
+void TC_Script::put32(uint32_t value) {
+  put16((uint16_t)(value & 0xFFFF));
+  put16((uint16_t)(value >> 16));
+}
+
+TC_Script &TC_Script::speed(double rev_per_sec) {
+  _bytes += (char)OP_SPEED;
+  put32(fixedSpeed(rev_per_sec));
+  return *this;
+}
+
+TC_Script &TC_Script::style(TC_Style style) {
+  _bytes += (char)OP_STYLE;
+  _bytes += (char)style;
+  return *this;
+}
+
+TC_Script &TC_Script::run(bool on) {
+  _bytes += (char)OP_RUN;
+  _bytes += (char)on;
+  return *this;
+}
+
+TC_Script &TC_Script::wait(uint32_t us) {
+  _bytes += (char)OP_WAIT;
+  put32(us);
+  return *this;
+}
+
+TC_Script &TC_Script::sweep(double rev_per_sec, uint32_t us) {
+  _bytes += (char)OP_SWEEP;
+  put32(fixedSpeed(rev_per_sec));
+  put32(us);
+  return *this;
+}
+
+TC_Script &TC_Script::loop(uint16_t count) {
+  _bytes += (char)OP_LOOP;
+  put16(count);
+  return *this;
+}
+
+TC_Script &TC_Script::next() {
+  _bytes += (char)OP_NEXT;
+  return *this;
+}
+
+TC_Script &TC_Script::led(uint32_t color, uint16_t fade_ms) {
+  _bytes += (char)OP_LED;
+  put32(color);
+  put16(fade_ms);
+  return *this;
+}
+
+TC_Script &TC_Script::ledOff(uint16_t fade_ms) {
+  _bytes += (char)OP_LED_OFF;
+  put16(fade_ms);
+  return *this;
+}
+
+TC_Script &TC_Script::end() {
+  _bytes += (char)OP_END;
+  return *this;
+}
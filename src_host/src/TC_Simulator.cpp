@@ -0,0 +1,125 @@
+#include "TC_Simulator.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+TC_Simulator::TC_Simulator() {}
+
+TC_Simulator::~TC_Simulator() { stop(); }
+
+void TC_Simulator::start() {
+  if (_master_fd >= 0) {
+    return;
+  }
+
+  int master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master_fd < 0 || grantpt(master_fd) != 0 || unlockpt(master_fd) != 0) {
+    if (master_fd >= 0) {
+      ::close(master_fd);
+    }
+    throw std::runtime_error(std::string("Cannot create pseudo-terminal: ") +
+                             std::strerror(errno));
+  }
+  _port_name = ptsname(master_fd);
+
+  // Raw mode on the slave side: no echo, no line editing, no CR/LF mangling
+  int slave_fd = ::open(_port_name.c_str(), O_RDWR | O_NOCTTY);
+  if (slave_fd < 0) {
+    ::close(master_fd);
+    throw std::runtime_error("Cannot open " + _port_name);
+  }
+  struct termios tio;
+  tcgetattr(slave_fd, &tio);
+  cfmakeraw(&tio);
+  tcsetattr(slave_fd, TCSANOW, &tio);
+
+  if (pipe(_wake_pipe) != 0) {
+    ::close(slave_fd);
+    ::close(master_fd);
+    throw std::runtime_error("Cannot create wake-up pipe");
+  }
+
+  _master_fd = master_fd;
+  _slave_fd = slave_fd;
+  _t_last = std::chrono::steady_clock::now();
+  writeAll(_model.boot());
+
+  _thread = std::thread(&TC_Simulator::serveLoop, this);
+}
+
+void TC_Simulator::stop() {
+  if (_master_fd < 0) {
+    return;
+  }
+
+  char c = 0;
+  if (write(_wake_pipe[1], &c, 1) < 0) {
+    // Nothing we can do, the join below will still return on error
+  }
+  if (_thread.joinable()) {
+    _thread.join();
+  }
+
+  ::close(_wake_pipe[0]);
+  ::close(_wake_pipe[1]);
+  _wake_pipe[0] = _wake_pipe[1] = -1;
+  ::close(_slave_fd);
+  ::close(_master_fd);
+  _slave_fd = _master_fd = -1;
+}
+
+void TC_Simulator::writeAll(const std::string &data) {
+  const char *p = data.data();
+  size_t left = data.size();
+  while (left > 0) {
+    ssize_t n = write(_master_fd, p, left);
+    if (n < 0) {
+      if (errno == EINTR || errno == EAGAIN) {
+        continue;
+      }
+      return;
+    }
+    p += n;
+    left -= (size_t)n;
+  }
+}
+
+void TC_Simulator::serveLoop() {
+  char buf[256];
+
+  for (;;) {
+    struct pollfd fds[2] = {{_master_fd, POLLIN, 0},
+                            {_wake_pipe[0], POLLIN, 0}};
+    int ret = poll(fds, 2, 1); // 1 ms tick to advance the virtual motor
+
+    auto t_now = std::chrono::steady_clock::now();
+    writeAll(
+        _model.advance(std::chrono::duration<double>(t_now - _t_last).count()));
+    _t_last = t_now;
+
+    if (ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    if (fds[1].revents) {
+      break; // `stop()` requested
+    }
+    if (!(fds[0].revents & POLLIN)) {
+      continue;
+    }
+
+    ssize_t n = read(_master_fd, buf, sizeof(buf));
+    if (n > 0) {
+      _model.receive(buf, (size_t)n);
+    }
+  }
+}
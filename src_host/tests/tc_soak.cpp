@@ -0,0 +1,323 @@
+/*
+tc_soak
+
+Soak test of the firmware timing across the wrap-arounds of `micros()` and
+`millis()`. Runs the firmware itself, `setup()` and `loop()` of main.cpp on
+the virtual clock of the board, see `TC_FirmwareModel.h` and `TC_Board.h`,
+for two simulated weeks. Starts right before `millis()` wraps around at 2^32
+ms, which is a wrap of `micros()` as well.
+
+The motor runs, the LED timeline plays and telemetry streams, all set up
+through commands on the programming port. Around each wrap of `micros()`,
+once every 71.6 min, `loop()` runs every microsecond for `WINDOW` on either
+side. In between, the clock hops ahead in steps short enough to keep the
+unsigned time differences of the firmware unambiguous. Everything is checked
+from the outside, on the step trigger pin and on what the firmware sends.
+Within every window
+
+  - each step follows the previous one after the step interval, +-1 us
+  - each telemetry record goes out on its deadline, a whole number of periods
+    on from the first, within the budget of its task, with `loop()` never
+    held up and no step late, so `micros64()` and the scheduler keep going
+  - the timeline keeps its frame interval, within a step interval, and the
+    strip keeps latching dither frames, per command 'leds'
+  - a timed command set for right after the wrap runs at the step nearest
+    to its time, per `micros64()`
+  - nothing stalls until the end of the window
+
+so that no wrap causes back-to-back steps, a stall or a skipped frame. The
+steps and records right at a hop are not checked. Exits with 1 at the first
+failure.
+
+Usage: tc_soak [-d days]
+*/
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "DvG_BinaryFrame.h"
+#include "DvG_Stepper.h"
+#include "DvG_Telemetry.h"
+#include "TC_Board.h"
+#include "TC_FirmwareModel.h"
+
+#define T_WRAP_MILLIS (1000ULL << 32) // [us] `millis()` and `micros()` wrap
+#define T_WRAP_MICROS (1ULL << 32)    // [us]
+#define WINDOW 100000                 // [us] Run on either side of a wrap
+#define SETTLE 40000 // [us] Run after a hop before the counters are reset
+#define T_AT 1000    // [us] Timed command this long after the wrap
+#define HOP_MAX (1ULL << 30) // [us] Below half the `micros()` range
+#define LOOP_US 1            // [us] Pass of `loop()`
+#define TOLERANCE 1.0        // [us]
+
+#define SETUP "r\nf2\n4\ntelem10\n" // Run at 2 Hz in MICROSTEP, telemetry
+#define TELEM_PERIOD 10000          // [us]
+#define TELEM_SLACK 100 // [us] `TX_BUDGET` of main.cpp, a record waits for
+                        // that much room before the next step
+#define TIMELINE_FRAME 20000        // [us] Default of `DvG_EffectTimeline`
+#define DITHER_MIN 40 // Dither frames per window, of some 57 at one per
+                      // three DMA blocks
+
+TC_FirmwareModel model(LOOP_US);
+
+// Intervals between the events of one kind, only checked while armed
+struct Tracker {
+  const char *name;
+  double nominal;   // [us]
+  double tolerance; // [us]
+  bool armed;
+  uint64_t t_last; // [us]
+  uint64_t n_checked;
+};
+
+Tracker tr_step = {"step", 0, TOLERANCE, false, 0, 0};
+Tracker tr_telem = {"telemetry", TELEM_PERIOD, TELEM_SLACK, false, 0, 0};
+uint64_t telem_deadline; // [us] Of the latest record
+
+static void fail(const char *name, const char *what, uint64_t value) {
+  uint64_t t = TC_Board::time();
+  std::printf("FAIL %s: %s %llu, at t = %llu us, micros() = %lu, "
+              "millis() = %lu\n",
+              name, what, (unsigned long long)value, (unsigned long long)t,
+              (unsigned long)(uint32_t)t, (unsigned long)(uint32_t)(t / 1000));
+  std::exit(1);
+}
+
+static void record(Tracker &tr, uint64_t t) {
+  if (tr.armed) {
+    uint64_t dt = t - tr.t_last;
+    if (std::fabs((double)dt - tr.nominal) > tr.tolerance) {
+      fail(tr.name, "interval [us]", dt);
+    }
+    tr.n_checked++;
+  }
+  tr.t_last = t;
+  tr.armed = true;
+}
+
+static void checkStall(const Tracker &tr) {
+  uint64_t t = TC_Board::time();
+  if (tr.armed && (double)(t - tr.t_last) > tr.nominal + tr.tolerance) {
+    fail(tr.name, "stalled for [us]", t - tr.t_last);
+  }
+}
+
+// OUTPUT OF THE FIRMWARE
+// ----------------------
+// Reply lines and telemetry frames, split up like `TC_Controller` does
+
+DvG_TelemetryDecoder telem_dec;
+
+struct Replies {
+  double steps_per_sec;  // Of the latest speed reply
+  uint32_t dithered;     // Of the latest 'leds'
+  uint32_t timeline_frames, timeline_min, timeline_max;
+  uint64_t at_t, at_now; // Of the latest timed 'clock'
+  uint64_t at_clock;
+} replies;
+
+static void onRecord(const DvG_TelemetryRecord &rec) {
+  // Unwrapped onto the board clock, valid while the records keep coming
+  uint64_t t = TC_Board::time();
+  t -= (uint32_t)((uint32_t)t - rec.t);
+
+  // The deadlines follow on from the first record after a hop, without drift
+  if (tr_telem.armed) {
+    telem_deadline += TELEM_PERIOD;
+    if (t < telem_deadline || t > telem_deadline + TELEM_SLACK) {
+      fail("telemetry", "record off its deadline [us]", telem_deadline);
+    }
+    if (rec.loop_max > LOOP_US) {
+      fail("telemetry", "loop_max [us]", rec.loop_max);
+    }
+    if (rec.jitter_max > TOLERANCE) {
+      fail("telemetry", "jitter_max [us]", rec.jitter_max);
+    }
+  } else {
+    telem_deadline = t;
+  }
+  record(tr_telem, t);
+}
+
+static void onLine(const std::string &line) {
+  const char *s = line.c_str();
+  unsigned long long a, b, c;
+  unsigned int n, lo, hi;
+  double f;
+
+  if (std::sscanf(s, "f = %*f Hz, %lf steps/s", &f) == 1) {
+    replies.steps_per_sec = f;
+  } else if (std::sscanf(s, "leds full %*u partial %*u skipped %*u latched "
+                            "%*u dithered %u",
+                         &n) == 1) {
+    replies.dithered = n;
+  } else if (std::sscanf(s, "leds timeline frames %u wait %*u interval %*u "
+                            "%u %u",
+                         &n, &lo, &hi) == 3) {
+    replies.timeline_frames = n;
+    replies.timeline_min = lo;
+    replies.timeline_max = hi;
+  } else if (std::sscanf(s, "at %llu %llu clock %llu", &a, &b, &c) == 3) {
+    replies.at_t = a;
+    replies.at_now = b;
+    replies.at_clock = c;
+  }
+}
+
+static void onFrame(std::string &frame) {
+  DvG_TelemetryRecord rec;
+  int16_t len = dvgFrameDecode((uint8_t *)&frame[0], (uint16_t)frame.size());
+  if (len < 0 || len > DVG_FRAME_PAYLOAD ||
+      !telem_dec.decode((const uint8_t *)frame.data(), (uint8_t)len, rec)) {
+    fail("telemetry", "bad frame of [bytes]", frame.size());
+  }
+  onRecord(rec);
+}
+
+static void take(const std::string &sent) {
+  static bool fBinary = false;
+  static std::string line, frame;
+
+  for (char c : sent) {
+    if (fBinary) {
+      if (c != 0) {
+        frame += c;
+      } else if (!frame.empty()) {
+        onFrame(frame);
+        frame.clear();
+        fBinary = false;
+      }
+    } else if (c == 0) {
+      fBinary = true;
+    } else if (c == '\r') {
+      continue;
+    } else if (c == '\n') {
+      onLine(line);
+      line.clear();
+    } else {
+      line += c;
+    }
+  }
+}
+
+// DRIVING THE FIRMWARE
+// --------------------
+
+static void send(const std::string &cmd) {
+  model.receive(cmd.data(), cmd.size());
+}
+
+static bool trig_step = false; // Level of `PIN_TRIG_STEP`, toggled per step
+
+// Run `loop()` every `LOOP_US` until `t`
+static void runTo(uint64_t t) {
+  while (TC_Board::time() < t) {
+    take(model.runLoop());
+    if (TC_Board::pin(PIN_TRIG_STEP) != trig_step) {
+      trig_step = !trig_step;
+      record(tr_step, TC_Board::time());
+    }
+  }
+}
+
+static void disarm() { tr_step.armed = tr_telem.armed = false; }
+
+// Jump ahead to `t`, running `loop()` once per hop. The steps and records
+// right at a hop are late by design, so none of them is checked nor used as
+// the start of an interval.
+static void hopTo(uint64_t t) {
+  while (TC_Board::time() < t) {
+    uint64_t dt = t - TC_Board::time();
+    TC_Board::setTime(TC_Board::time() + (dt < HOP_MAX ? dt : HOP_MAX) -
+                      LOOP_US);
+    disarm();
+    runTo(TC_Board::time() + LOOP_US);
+  }
+  disarm();
+}
+
+int main(int argc, char **argv) {
+  double days = 14;
+
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+      days = std::atof(argv[++i]);
+    } else {
+      std::fprintf(stderr, "Usage: %s [-d days]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  take(model.boot());
+  send(SETUP);
+  take(model.advance(SETTLE * 1e-6)); // Not checked, the motor starts
+  if (replies.steps_per_sec <= 0) {
+    std::printf("FAIL no speed reply to '" SETUP "'\n");
+    return 1;
+  }
+  tr_step.nominal = 1e6 / replies.steps_per_sec - STEPPER_I2C_OVERHEAD;
+
+  uint64_t t_end = T_WRAP_MILLIS + (uint64_t)(days * 86400e6);
+  uint32_t n_wraps = 0;
+  uint64_t n_frames = 0;
+
+  for (uint64_t t_wrap = T_WRAP_MILLIS; t_wrap <= t_end;
+       t_wrap += T_WRAP_MICROS) {
+    hopTo(t_wrap - WINDOW);
+    runTo(t_wrap - WINDOW + SETTLE);
+    send("leds\n@" + std::to_string(t_wrap + T_AT) + " clock\n");
+    runTo(t_wrap + WINDOW);
+    checkStall(tr_step);
+    checkStall(tr_telem);
+
+    // Ran at the step nearest to its time, by a clock that did not miss
+    // the wrap
+    if (replies.at_t != t_wrap + T_AT) {
+      fail("timed command", "not run, queued for [us]", t_wrap + T_AT);
+    }
+    uint64_t late = (replies.at_now > replies.at_t
+                         ? replies.at_now - replies.at_t
+                         : replies.at_t - replies.at_now);
+    if (late > tr_step.nominal / 2 + TOLERANCE) {
+      fail("timed command", "run off its time by [us]", late);
+    }
+    if (replies.at_clock != replies.at_now) {
+      fail("timed command", "micros64() inconsistent by [us]",
+           replies.at_clock - replies.at_now);
+    }
+
+    // The counters since the reset after `SETTLE`
+    replies.timeline_frames = 0;
+    send("leds\n");
+    runTo(TC_Board::time() + 1000);
+    if (replies.timeline_frames < 2) {
+      fail("timeline", "frames", replies.timeline_frames);
+    }
+    if (replies.timeline_min + tr_step.nominal < TIMELINE_FRAME) {
+      fail("timeline", "interval min [us]", replies.timeline_min);
+    }
+    if (replies.timeline_max > TIMELINE_FRAME + tr_step.nominal) {
+      fail("timeline", "interval max [us]", replies.timeline_max);
+    }
+    if (replies.dithered < DITHER_MIN) {
+      fail("strip", "dithered frames", replies.dithered);
+    }
+    n_frames += replies.timeline_frames;
+    n_wraps++;
+  }
+
+  std::printf("%u wraps of micros() in %.1f days, 1 of millis()\n", n_wraps,
+              days);
+  std::printf("%-9s %9llu intervals of %.1f us\n", tr_step.name,
+              (unsigned long long)tr_step.n_checked, tr_step.nominal);
+  std::printf("%-9s %9llu intervals of %.1f us\n", tr_telem.name,
+              (unsigned long long)tr_telem.n_checked, tr_telem.nominal);
+  std::printf("%-9s %9llu frames of %u us\n", "timeline",
+              (unsigned long long)n_frames, TIMELINE_FRAME);
+  std::printf("%-9s %9u timed commands\n", "@t", n_wraps);
+  std::printf("ok\n");
+  return 0;
+}
@@ -0,0 +1,153 @@
+/*
+tc_colorbench
+
+Host benchmark of the flash-resident colour tables of DvG_NeoPixel_Effects,
+see `DvG_ColorTables.h`. First verifies that every table entry equals the
+colour computed by the original code, then times rendering a strip of pixels
+per frame with
+
+  Wheel()     : the former branch-and-multiply `DvG_NeoPixel_Effects::Wheel()`
+  ColorHSV()  : `Adafruit_NeoPixel::ColorHSV()` at full saturation and value
+  tables      : a single fetch from `dvg_wheel_table` / `dvg_hue_table`
+
+Usage: tc_colorbench [-n frames] [-p pixels]
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "DvG_ColorTables.h"
+
+// Reference copies of the original firmware code
+
+static uint32_t Color(uint8_t r, uint8_t g, uint8_t b, uint8_t w) {
+  return ((uint32_t)w << 24) | ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+}
+
+static uint32_t Wheel(uint8_t WheelPos) {
+  WheelPos = 255 - WheelPos;
+  if (WheelPos < 85) {
+    return Color(255 - WheelPos * 3, 0, WheelPos * 3, 0);
+  }
+  if (WheelPos < 170) {
+    WheelPos -= 85;
+    return Color(0, WheelPos * 3, 255 - WheelPos * 3, 0);
+  }
+  WheelPos -= 170;
+  return Color(WheelPos * 3, 255 - WheelPos * 3, 0, 0);
+}
+
+static uint32_t ColorHSV(uint16_t hue, uint8_t sat = 255, uint8_t val = 255) {
+  uint8_t r, g, b;
+
+  hue = (hue * 1530L + 32768) / 65536;
+  if (hue < 510) {
+    b = 0;
+    if (hue < 255) {
+      r = 255;
+      g = hue;
+    } else {
+      r = 510 - hue;
+      g = 255;
+    }
+  } else if (hue < 1020) {
+    r = 0;
+    if (hue < 765) {
+      g = 255;
+      b = hue - 510;
+    } else {
+      g = 1020 - hue;
+      b = 255;
+    }
+  } else if (hue < 1530) {
+    g = 0;
+    if (hue < 1275) {
+      r = hue - 1020;
+      b = 255;
+    } else {
+      r = 255;
+      b = 1530 - hue;
+    }
+  } else {
+    r = 255;
+    g = b = 0;
+  }
+
+  uint32_t v1 = 1 + val;
+  uint16_t s1 = 1 + sat;
+  uint8_t s2 = 255 - sat;
+  return ((((((r * s1) >> 8) + s2) * v1) & 0xff00) << 8) |
+         (((((g * s1) >> 8) + s2) * v1) & 0xff00) |
+         (((((b * s1) >> 8) + s2) * v1) >> 8);
+}
+
+static volatile uint32_t sink; // Keeps the optimizer from dropping the work
+
+template <typename F>
+static double timeFrames(const char *name, int frames, int pixels, F color) {
+  auto t0 = std::chrono::steady_clock::now();
+  for (int j = 0; j < frames; ++j) {
+    uint32_t acc = 0;
+    for (int i = 0; i < pixels; ++i) {
+      acc ^= color((uint8_t)(i * 256 / pixels + j));
+    }
+    sink = acc;
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() /
+              ((double)frames * pixels);
+  std::printf("%-12s %8.2f ns/pixel\n", name, ns);
+  return ns;
+}
+
+int main(int argc, char **argv) {
+  int frames = 200000;
+  int pixels = 16;
+
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      frames = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+      pixels = std::atoi(argv[++i]);
+    } else {
+      std::fprintf(stderr, "Usage: %s [-n frames] [-p pixels]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (frames < 1 || pixels < 1) {
+    std::fprintf(stderr, "Frames and pixels must be positive\n");
+    return 1;
+  }
+
+  int mismatches = 0;
+  for (int i = 0; i < 256; ++i) {
+    if (dvg_wheel_table[i] != Wheel(i)) {
+      std::printf("dvg_wheel_table[%d] = %06x, Wheel() = %06x\n", i,
+                  dvg_wheel_table[i], Wheel(i));
+      mismatches++;
+    }
+    if (dvg_hue_table[i] != ColorHSV(i * 256)) {
+      std::printf("dvg_hue_table[%d] = %06x, ColorHSV() = %06x\n", i,
+                  dvg_hue_table[i], ColorHSV(i * 256));
+      mismatches++;
+    }
+  }
+  if (mismatches) {
+    std::printf("%d table entries differ from the reference\n", mismatches);
+    return 1;
+  }
+  std::printf("Tables match the reference, %d frames of %d pixels\n", frames,
+              pixels);
+
+  timeFrames("Wheel()", frames, pixels, [](uint8_t i) { return Wheel(i); });
+  timeFrames("wheel table", frames, pixels,
+             [](uint8_t i) { return dvg_wheel_table[i]; });
+  timeFrames("ColorHSV()", frames, pixels,
+             [](uint8_t i) { return ColorHSV(i * 256); });
+  timeFrames("hue table", frames, pixels,
+             [](uint8_t i) { return dvg_hue_table[i]; });
+
+  return 0;
+}
@@ -0,0 +1,131 @@
+/*
+tc_latency
+
+End-to-end command-to-step latency benchmark. Alternates the speed between two
+setpoints thousands of times and collects the latency reports of the firmware,
+see command 'lat' in main.cpp. Prints the p50 / p99 / max distribution of
+
+  rx -> dispatch : linefeed received until the command is handled
+  rx -> step     : linefeed received until the first step at the new interval
+  round trip     : host write until the speed reply has been read
+
+Usage: tc_latency [port] [-n count] [-f speed] [-b baudrate]
+Without a port, the benchmark runs against its own `TC_Simulator`.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "TC_Controller.h"
+#include "TC_Simulator.h"
+
+static void printStats(const char *name, std::vector<double> v) {
+  if (v.empty()) {
+    std::printf("%-16s no samples\n", name);
+    return;
+  }
+  std::sort(v.begin(), v.end());
+  auto pct = [&v](double p) {
+    size_t i = (size_t)std::max(0.0, std::ceil(p * v.size()) - 1);
+    return v[std::min(i, v.size() - 1)];
+  };
+  std::printf("%-16s p50 %9.1f   p99 %9.1f   max %9.1f  [us]\n", name,
+              pct(0.50), pct(0.99), v.back());
+}
+
+int main(int argc, char **argv) {
+  std::string port;
+  int count = 2000;
+  int baudrate = 115200;
+  float speed = 2.0f; // [rev per sec]
+
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      count = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+      speed = (float)std::atof(argv[++i]);
+    } else if (std::strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+      baudrate = std::atoi(argv[++i]);
+    } else if (argv[i][0] != '-') {
+      port = argv[i];
+    } else {
+      std::fprintf(stderr,
+                   "Usage: %s [port] [-n count] [-f speed] [-b baudrate]\n",
+                   argv[0]);
+      return 1;
+    }
+  }
+
+  TC_Simulator sim;
+  if (port.empty()) {
+    sim.start();
+    port = sim.portName();
+    std::printf("Using simulator at %s\n", port.c_str());
+  }
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<TC_Latency> reports;
+
+  TC_Controller tc(port, baudrate);
+  tc.setUnsolicitedCallback([&](const std::string &line) {
+    TC_Latency lat;
+    if (parseLatencyReport(line, lat)) {
+      std::lock_guard<std::mutex> lock(mutex);
+      reports.push_back(lat);
+      cv.notify_one();
+    }
+  });
+
+  try {
+    tc.open();
+    while (!tc.toggleLatencyReport().get()) {}
+    while (!tc.toggleRun().get()) {}
+
+    std::vector<double> rx_to_dispatch, rx_to_step, round_trip;
+    int timeouts = 0;
+
+    for (int i = 0; i < count; ++i) {
+      float setpoint = (i % 2 ? speed + 0.05f : speed);
+      auto t0 = std::chrono::steady_clock::now();
+      tc.setSpeed(setpoint).get();
+      auto t1 = std::chrono::steady_clock::now();
+      round_trip.push_back(
+          std::chrono::duration<double, std::micro>(t1 - t0).count());
+
+      std::unique_lock<std::mutex> lock(mutex);
+      if (!cv.wait_for(lock, std::chrono::seconds(1),
+                       [&reports] { return !reports.empty(); })) {
+        timeouts++;
+        continue;
+      }
+      TC_Latency lat = reports.front();
+      reports.pop_front();
+      rx_to_dispatch.push_back(lat.rxToDispatch());
+      rx_to_step.push_back(lat.rxToStep());
+    }
+
+    while (tc.toggleRun().get()) {}
+    while (tc.toggleLatencyReport().get()) {}
+
+    std::printf("%d commands, %d without latency report\n", count, timeouts);
+    printStats("rx -> dispatch", rx_to_dispatch);
+    printStats("rx -> step", rx_to_step);
+    printStats("round trip", round_trip);
+
+  } catch (const std::exception &e) {
+    std::fprintf(stderr, "Error: %s\n", e.what());
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,102 @@
+/*
+tc_log
+
+Log the telemetry stream of the firmware, see command 'telem' in main.cpp, as
+CSV on stdout, one row per record:
+
+  t_us, speed, position, style, running, jitter_avg, jitter_max, loop_avg,
+  loop_max, leds_shown, leds_skipped, leds_deferred, leds_limited
+
+`speed` is in [rev per sec], times in [us]. At the end the number of records
+and of gaps in the stream go to stderr.
+
+Usage: tc_log [port] [-p period_ms] [-t seconds] [-b baudrate]
+Without a port, it logs its own `TC_Simulator`. Short periods need the
+native USB port of the firmware, the programming port tops out at 115200
+baud.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "TC_Controller.h"
+#include "TC_Simulator.h"
+
+int main(int argc, char **argv) {
+  std::string port;
+  int period = 100; // [ms]
+  double duration = 10.0; // [s]
+  int baudrate = 115200;
+
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+      period = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+      duration = std::atof(argv[++i]);
+    } else if (std::strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+      baudrate = std::atoi(argv[++i]);
+    } else if (argv[i][0] != '-') {
+      port = argv[i];
+    } else {
+      std::fprintf(stderr,
+                   "Usage: %s [port] [-p period_ms] [-t seconds] "
+                   "[-b baudrate]\n",
+                   argv[0]);
+      return 1;
+    }
+  }
+  if (period < 1 || duration <= 0) {
+    std::fprintf(stderr, "Period and duration must be positive\n");
+    return 1;
+  }
+
+  TC_Simulator sim;
+  if (port.empty()) {
+    sim.start();
+    port = sim.portName();
+    std::fprintf(stderr, "Using simulator at %s\n", port.c_str());
+  }
+
+  std::mutex mutex; // Serializes the rows
+  unsigned long records = 0;
+
+  TC_Controller tc(port, baudrate);
+  tc.setTelemetryCallback([&](const DvG_TelemetryRecord &rec) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::printf("%lu,%.6f,%ld,%u,%d,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu\n",
+                (unsigned long)rec.t, rec.speed * 1e-6, (long)rec.position,
+                rec.style, rec.running, (unsigned long)rec.jitter_avg,
+                (unsigned long)rec.jitter_max, (unsigned long)rec.loop_avg,
+                (unsigned long)rec.loop_max, (unsigned long)rec.leds_shown,
+                (unsigned long)rec.leds_skipped,
+                (unsigned long)rec.leds_deferred,
+                (unsigned long)rec.leds_limited);
+    records++;
+  });
+
+  try {
+    tc.open();
+    std::printf("t_us,speed,position,style,running,jitter_avg,jitter_max,"
+                "loop_avg,loop_max,leds_shown,leds_skipped,leds_deferred,"
+                "leds_limited\n");
+    uint32_t actual = tc.setTelemetry((uint32_t)period).get();
+    std::fprintf(stderr, "Telemetry every %u ms for %.1f s\n",
+                 (unsigned)actual, duration);
+    std::this_thread::sleep_for(std::chrono::duration<double>(duration));
+    tc.setTelemetry(0).get();
+  } catch (const std::exception &e) {
+    std::fprintf(stderr, "Error: %s\n", e.what());
+    return 1;
+  }
+
+  tc.close();
+  std::lock_guard<std::mutex> lock(mutex);
+  std::fprintf(stderr, "%lu records, %u gaps\n", records,
+               (unsigned)tc.telemetryGaps());
+  return 0;
+}
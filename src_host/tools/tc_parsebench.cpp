@@ -0,0 +1,213 @@
+/*
+tc_parsebench
+
+Host benchmark of the fixed-point number parser of the firmware, see
+`DvG_ParseFixed.h`, against the `atof()` it replaces in the speed commands.
+Generates random decimal strings, with and without sign, fraction and
+exponent, and checks:
+
+  exact     : `dvgParseFixed()` against the exactly rounded value, calculated
+              from the generated digits in 128-bit integer arithmetic
+  atof      : the former `(float)atof()` scaled to the same fixed point,
+              reporting how far it strays from the exact value
+  interval  : the step interval of `DvG_Stepper::setSpeedFixed()` against
+              that of `DvG_Stepper::setSpeed()` for speeds of 0.01 to 10
+              rev per sec, in all stepping styles
+
+and then times parsing typical speed arguments.
+
+Usage: tc_parsebench [-n strings] [-d decimals]
+*/
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "DvG_ParseFixed.h"
+
+#define FIXED_MAX 2147483647
+
+// A random decimal number, both as text and as the exact integer `mant`
+// times 10^`exp10`
+struct Sample {
+  std::string text;
+  bool neg;
+  int64_t mant;
+  int exp10;
+};
+
+static Sample randomSample(std::mt19937 &rng) {
+  Sample s;
+  auto pick = [&](int n) { return (int)(rng() % n); };
+  int n_int = pick(5);  // Integer digits
+  int n_frac = pick(9); // Fraction digits
+  bool point = (n_frac > 0 || pick(4) == 0);
+
+  if (n_int == 0 && n_frac == 0) n_int = 1;
+  s.neg = (pick(3) == 0);
+  s.text = s.neg ? "-" : (pick(8) == 0 ? "+" : "");
+  s.mant = 0;
+  s.exp10 = -n_frac;
+  for (int i = 0; i < n_int + n_frac; i++) {
+    if (i == n_int && point) s.text += '.';
+    int digit = pick(10);
+    s.text += (char)('0' + digit);
+    s.mant = s.mant * 10 + digit;
+  }
+  if (n_frac == 0 && point) s.text += '.';
+  if (pick(5) == 0) {
+    int e = pick(13) - 6;
+    s.text += (pick(2) ? "e" : "E") + std::to_string(e);
+    s.exp10 += e;
+  }
+  return s;
+}
+
+// Exact value times 10^`decimals`, rounded half away from zero, saturated
+static int32_t exactFixed(const Sample &s, int decimals) {
+  __int128 num = s.mant;
+  __int128 den = 1;
+  int e = s.exp10 + decimals;
+
+  for (; e > 0 && num <= FIXED_MAX; e--) num *= 10;
+  for (; e < 0; e++) den *= 10;
+  num = (2 * num + den) / (2 * den);
+  if (num > FIXED_MAX) num = FIXED_MAX;
+  return (int32_t)(s.neg ? -num : num);
+}
+
+// The former parse: `(float)atof()`, then scaled to the fixed point
+static int32_t atofFixed(const char *text, int decimals) {
+  double value = (double)(float)std::atof(text) * std::pow(10., decimals);
+  if (std::fabs(value) > FIXED_MAX) value = std::copysign(FIXED_MAX, value);
+  return (int32_t)std::lround(value);
+}
+
+// `DvG_Stepper::setSpeed()`, before the I2C overhead is subtracted
+static uint32_t intervalFloat(float rev_per_sec, uint32_t steps_per_rev) {
+  float steps_per_sec = rev_per_sec * steps_per_rev;
+  return (uint32_t)std::min(std::fabs(1000000. / steps_per_sec), 4294967295.);
+}
+
+// `DvG_Stepper::setSpeedFixed()`, idem
+static uint32_t intervalFixed(int32_t speed, uint32_t steps_per_rev) {
+  uint64_t steps_per_sec = (uint64_t)std::llabs(speed) * steps_per_rev;
+  return (uint32_t)std::min<uint64_t>(
+      steps_per_sec ? 1000000000000ULL / steps_per_sec : 0xFFFFFFFF,
+      0xFFFFFFFF);
+}
+
+static volatile int64_t sink; // Keeps the optimizer from dropping the work
+
+template <typename F>
+static void timeParse(const char *name, const std::vector<std::string> &args,
+                      int rounds, F parse) {
+  auto t0 = std::chrono::steady_clock::now();
+  int64_t acc = 0;
+  for (int j = 0; j < rounds; ++j) {
+    for (const std::string &arg : args) {
+      acc += parse(arg.c_str());
+    }
+  }
+  sink = acc;
+  auto t1 = std::chrono::steady_clock::now();
+  double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() /
+              ((double)rounds * args.size());
+  std::printf("%-16s %8.2f ns/parse\n", name, ns);
+}
+
+int main(int argc, char **argv) {
+  int count = 1000000;
+  int decimals = 6; // `STEPPER_SPEED_DECIMALS`
+
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      count = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+      decimals = std::atoi(argv[++i]);
+    } else {
+      std::fprintf(stderr, "Usage: %s [-n strings] [-d decimals]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (count < 1 || decimals < 0 || decimals > 9) {
+    std::fprintf(stderr, "Strings must be positive, decimals 0 to 9\n");
+    return 1;
+  }
+
+  // Accuracy against the exact value
+  std::mt19937 rng(1);
+  int mismatches = 0;
+  int atof_off = 0;
+  int64_t atof_max = 0;
+  for (int i = 0; i < count; ++i) {
+    Sample s = randomSample(rng);
+    const char *end;
+    int32_t fixed = dvgParseFixed(s.text.c_str(), decimals, &end);
+    int32_t exact = exactFixed(s, decimals);
+    if (fixed != exact || *end != '\0') {
+      if (mismatches < 10) {
+        std::printf("\"%s\": dvgParseFixed() = %d, exact = %d\n",
+                    s.text.c_str(), fixed, exact);
+      }
+      mismatches++;
+    }
+    int64_t diff = std::llabs((int64_t)atofFixed(s.text.c_str(), decimals) -
+                              exact);
+    if (diff) atof_off++;
+    if (diff > atof_max) atof_max = diff;
+  }
+  if (mismatches) {
+    std::printf("%d of %d strings differ from the exact value\n", mismatches,
+                count);
+    return 1;
+  }
+  std::printf("exact     %d strings, %d decimals: all match\n", count,
+              decimals);
+  std::printf("atof      %d strings off by up to %lld units of 1e-%d\n",
+              atof_off, (long long)atof_max, decimals);
+
+  // Step intervals, SINGLE and DOUBLE, INTERLEAVE and MICROSTEP
+  if (decimals == 6) {
+    const uint32_t steps_per_rev[] = {200, 400, 1600};
+    int n_speeds = 0;
+    int interval_off = 0;
+    int64_t interval_max = 0;
+    for (int32_t speed = 10000; speed <= 10000000; speed += 37) {
+      std::string text = std::to_string(speed / 1000000) + "." +
+                         std::to_string(1000000 + speed % 1000000).substr(1);
+      float f = (float)std::atof(text.c_str());
+      int32_t fixed = dvgParseFixed(text.c_str(), decimals);
+      for (uint32_t spr : steps_per_rev) {
+        int64_t diff = std::llabs((int64_t)intervalFloat(f, spr) -
+                                  intervalFixed(fixed, spr));
+        if (diff) interval_off++;
+        if (diff > interval_max) interval_max = diff;
+      }
+      n_speeds++;
+    }
+    std::printf("interval  %d of %d step intervals off by up to %lld us\n",
+                interval_off, n_speeds * 3, (long long)interval_max);
+  }
+
+  // Speed
+  std::vector<std::string> args;
+  for (int i = 0; i < 1000; ++i) {
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "%.2f", (int)(rng() % 1000) / 100.);
+    args.push_back(buf);
+  }
+  int rounds = std::max(1, count / 1000);
+  timeParse("atof()", args, rounds, [](const char *s) {
+    return (int64_t)std::lround((float)std::atof(s) * 1e6);
+  });
+  timeParse("dvgParseFixed()", args, rounds,
+            [decimals](const char *s) { return dvgParseFixed(s, decimals); });
+
+  return 0;
+}
@@ -0,0 +1,34 @@
+/*
+tc_sim
+
+Start the device simulator and print the path of its pseudo-terminal. Point
+your experiment scripts or a terminal program at that path instead of the real
+serial port. Runs until interrupted with Ctrl+C.
+*/
+
+#include <csignal>
+#include <cstdio>
+#include <unistd.h>
+
+#include "TC_Simulator.h"
+
+static volatile sig_atomic_t fStop = 0;
+
+static void onSignal(int) { fStop = 1; }
+
+int main() {
+  std::signal(SIGINT, onSignal);
+  std::signal(SIGTERM, onSignal);
+
+  TC_Simulator sim;
+  sim.start();
+  std::printf("%s\n", sim.portName().c_str());
+  std::fflush(stdout);
+
+  while (!fStop) {
+    pause();
+  }
+
+  sim.stop();
+  return 0;
+}
@@ -34,6 +34,7 @@ and pins for each).
 
 #include "Adafruit_NeoPixel_ZeroDMA.h"
 #include "bittable.h"       // Optional, see comments in show()
+#include "gammatable16.h"   // Temporal dithering
 #include "pins.h"           // SPI DMA capable pin tables (per device)
 #include "wiring_private.h" // pinPeripheral() function
 
@@ -44,17 +45,49 @@ and pins for each).
 */
 Adafruit_NeoPixel_ZeroDMA::Adafruit_NeoPixel_ZeroDMA(uint16_t n, uint8_t p,
                                                      neoPixelType t)
-    : Adafruit_NeoPixel(n, p, t), brightness(256), dmaBuf(NULL), spi(NULL) {}
+    : Adafruit_NeoPixel(n, p, t), spi(NULL), dmaBuf(NULL), dmaBufBack(NULL),
+      dmaMem(NULL), staticDmaMem(NULL), staticDmaSize(0), staticStrobeMem(NULL),
+      staticStrobeSize(0), staticDitherMem(NULL), staticDitherSize(0),
+      brightness(256), dirtyStart(0xFFFF), dirtyEnd(0), powerSum(0),
+      powerLimit(0), limitedBrightness(256), framesLimited(0), framesFull(0),
+      framesPartial(0), framesSkipped(0), doubleBuffer(false),
+      fShowDeferred(false), asyncState(ASYNC_IDLE), framesLatched(0),
+      desc(NULL), lastStart(0xFFFF), lastEnd(0), latchCallback(NULL),
+      strobe(false), strobeOn(NULL), strobeOff(NULL), strobeOnColor(0),
+      strobeOffColor(0), strobePasses(0), strobeFlashes(0), dither(false),
+      ditherLevels(NULL), ditherAcc(NULL), framesDithered(0),
+      framesDeferred(0), tDeferred(0), expandCount(0), expandTime(0),
+      expandTimeMax(0), waitCount(0), waitTime(0), waitTimeMax(0) {
+  buildExpandTable();
+}
 
 /** @brief Create a NOT FINISHED onject -- need setPin(), updateLength(),
     updateType() for this.
     Will require stopping DMA, reallocating, restarting DMA.  Fun times.
 */
 Adafruit_NeoPixel_ZeroDMA::Adafruit_NeoPixel_ZeroDMA(void)
-    : Adafruit_NeoPixel(), brightness(256), dmaBuf(NULL), spi(NULL) {}
+    : Adafruit_NeoPixel(), spi(NULL), dmaBuf(NULL), dmaBufBack(NULL),
+      dmaMem(NULL), staticDmaMem(NULL), staticDmaSize(0), staticStrobeMem(NULL),
+      staticStrobeSize(0), staticDitherMem(NULL), staticDitherSize(0),
+      brightness(256), dirtyStart(0xFFFF), dirtyEnd(0), powerSum(0),
+      powerLimit(0), limitedBrightness(256), framesLimited(0), framesFull(0),
+      framesPartial(0), framesSkipped(0), doubleBuffer(false),
+      fShowDeferred(false), asyncState(ASYNC_IDLE), framesLatched(0),
+      desc(NULL), lastStart(0xFFFF), lastEnd(0), latchCallback(NULL),
+      strobe(false), strobeOn(NULL), strobeOff(NULL), strobeOnColor(0),
+      strobeOffColor(0), strobePasses(0), strobeFlashes(0), dither(false),
+      ditherLevels(NULL), ditherAcc(NULL), framesDithered(0),
+      framesDeferred(0), tDeferred(0), expandCount(0), expandTime(0),
+      expandTimeMax(0), waitCount(0), waitTime(0), waitTimeMax(0) {
+  buildExpandTable();
+}
+
+Adafruit_NeoPixel_ZeroDMA *Adafruit_NeoPixel_ZeroDMA::instances[DMAC_CH_NUM];
 
 Adafruit_NeoPixel_ZeroDMA::~Adafruit_NeoPixel_ZeroDMA() {
   dma.abort();
+  if (desc && (dma.getChannel() < DMAC_CH_NUM))
+    instances[dma.getChannel()] = NULL;
   if (spi) {
     spi->endTransaction();
 #ifdef SPI
@@ -62,8 +95,11 @@ Adafruit_NeoPixel_ZeroDMA::~Adafruit_NeoPixel_ZeroDMA() {
       delete spi;
 #endif
   }
-  if (dmaBuf)
-    free(dmaBuf);
+  freeDmaMem();
+  if (strobeOn && (strobeOn != staticStrobeMem))
+    free(strobeOn);
+  if (ditherLevels && ((uint8_t *)ditherLevels != staticDitherMem))
+    free(ditherLevels);
 }
 
 /** @brief Initialize the underlying SPI SERCOM for DMA transfers
@@ -101,7 +137,9 @@ bool Adafruit_NeoPixel_ZeroDMA::begin(SERCOM *sercom, Sercom *sercomBase,
 
   uint8_t bytesPerPixel = (wOffset == rOffset) ? 3 : 4;
   uint32_t bytesTotal = (numLEDs * bytesPerPixel * 8 * 3 + 7) / 8 + 90;
-  if ((dmaBuf = (uint8_t *)malloc(bytesTotal))) {
+  if ((dmaBuf = dmaMem =
+           allocDmaMem(doubleBuffer ? bytesTotal * 2 : bytesTotal))) {
+    dmaBufBack = doubleBuffer ? dmaBuf + bytesTotal : NULL;
     spi = NULL; // No SPIClass assigned yet,
                 // check MOSI pin against existing defined SPI SERCOMs...
 #if SPI_INTERFACES_COUNT > 0
@@ -165,14 +203,20 @@ bool Adafruit_NeoPixel_ZeroDMA::begin(SERCOM *sercom, Sercom *sercomBase,
       dma.setTrigger(dmacID);
       dma.setAction(DMA_TRIGGER_ACTON_BEAT);
       if (DMA_STATUS_OK == dma.allocate()) {
-        if (dma.addDescriptor(dmaBuf, // move data from here
-                              (void *)(&sercomBase->SPI.DATA.reg), // to here
-                              bytesTotal,         // this many...
-                              DMA_BEAT_SIZE_BYTE, // bytes/hword/words
-                              true,               // increment source addr?
-                              false)) {           // increment dest addr?
+        if ((desc = dma.addDescriptor(
+                 dmaBuf,                              // move data from here
+                 (void *)(&sercomBase->SPI.DATA.reg), // to here
+                 bytesTotal,                          // this many...
+                 DMA_BEAT_SIZE_BYTE,                  // bytes/hword/words
+                 true,                                // increment source addr?
+                 false))) {                           // increment dest addr?
           dma.loop(true); // DMA transaction loops forever! Latch is built in.
           memset(dmaBuf, 0, bytesTotal); // IMPORTANT - clears latch data @ end
+          if (doubleBuffer) {
+            memset(dmaBufBack, 0, bytesTotal);
+            enableBlockInterrupt();
+          }
+          invalidate(); // Next show() must expand the whole strip
           // SPI transaction is started BUT NEVER ENDS.  This is important.
           // 800 khz * 3 = 2.4MHz
           spi->beginTransaction(SPISettings(2400000, MSBFIRST, SPI_MODE0));
@@ -222,12 +266,43 @@ bool Adafruit_NeoPixel_ZeroDMA::begin(SERCOM *sercom, Sercom *sercomBase,
       }
 #endif
     }
-    free(dmaBuf);
-    dmaBuf = NULL;
+    freeDmaMem();
+    dmaBuf = dmaBufBack = NULL;
+    desc = NULL;
   }
   return false;
 }
 
+/** @brief Get memory from a static buffer of
+    Adafruit_NeoPixel_ZeroDMA_Static when set, else from the heap
+    @param staticMem Static buffer, or NULL
+    @param staticSize Size of staticMem
+    @param size Number of bytes
+    @returns Pointer to the memory, or NULL when it does not fit
+*/
+uint8_t *Adafruit_NeoPixel_ZeroDMA::allocMem(uint8_t *staticMem,
+                                             uint32_t staticSize,
+                                             uint32_t size) {
+  if (staticMem)
+    return (size <= staticSize) ? staticMem : NULL;
+  return (uint8_t *)malloc(size);
+}
+
+/** @brief Get the memory for the DMA buffer(s), see allocMem()
+    @param size Number of bytes
+    @returns Pointer to the memory, or NULL when it does not fit
+*/
+uint8_t *Adafruit_NeoPixel_ZeroDMA::allocDmaMem(uint32_t size) {
+  return allocMem(staticDmaMem, staticDmaSize, size);
+}
+
+/** @brief Release the memory of allocDmaMem() */
+void Adafruit_NeoPixel_ZeroDMA::freeDmaMem(void) {
+  if (dmaMem && (dmaMem != staticDmaMem))
+    free(dmaMem);
+  dmaMem = NULL;
+}
+
 #ifdef __SAMD51__
 // See notes below about M4 tomfoolery
 #define EXTRASTARTBYTES 24 // Empty bytes issued until DMA timing solidifies
@@ -261,7 +336,7 @@ bool Adafruit_NeoPixel_ZeroDMA::begin(void) {
     Adafruit_NeoPixel::begin(); // Call base class begin() function 1st
     uint8_t bytesPerPixel = (wOffset == rOffset) ? 3 : 4;
     uint32_t bytesTotal = (numLEDs * bytesPerPixel * 32 + EXTRASTARTBYTES);
-    if ((dmaBuf = (uint8_t *)malloc(bytesTotal))) {
+    if ((dmaBuf = dmaMem = (uint8_t *)malloc(bytesTotal))) {
       int i;
 
       pinMode(pin, OUTPUT);
@@ -337,6 +412,7 @@ bool Adafruit_NeoPixel_ZeroDMA::begin(void) {
         ;
 
       memset(dmaBuf, 0, EXTRASTARTBYTES); // Initialize buf start with zeros
+      invalidate();
 
       return true;
     }
@@ -357,47 +433,133 @@ void Adafruit_NeoPixel_ZeroDMA::show(void) {
   if (!toggleMask) { // Using normal SERCOM DMA technique?
 #endif
 
-    // Expand 8 bits 'abcdefgh' to 24 bits '1a01b01c01d01e01f01g01h0'
-#ifdef _BITTABLE_H_
-    // If bittable.h is included, 3:1 bit expansion is handled using a table
-    // lookup -- each byte of input (from NeoPixel buffer) is replaced with
-    // three bytes output (from table to DMA buffer).  This is about twice
-    // as quick as math below but the table requires about 1KB of code space.
-    uint8_t *in = pixels, *out = dmaBuf;
+    // Only the bytes that changed since the previous call get re-expanded.
+    // The DMA transfer loops endlessly over `dmaBuf`, so when nothing
+    // changed there is nothing left to do at all.
+    if (dirtyStart >= dirtyEnd) {
+      framesSkipped++;
+      return;
+    }
+
+    uint32_t t_start = micros();
+    uint16_t b = limitBrightness();
+    if (dither) {
+      // ditherFrame() takes it from here
+      if (b != limitedBrightness) {
+        limitedBrightness = b; // Every level changes
+        updateDitherLevels(0, numBytes);
+      } else {
+        updateDitherLevels(dirtyStart, dirtyEnd);
+      }
+      if (b < brightness)
+        framesLimited++;
+      recordExpandTime(t_start);
+      if (dirtyStart == 0 && dirtyEnd >= numBytes) {
+        framesFull++;
+      } else {
+        framesPartial++;
+      }
+      dirtyStart = 0xFFFF;
+      dirtyEnd = 0;
+      return;
+    }
+    if (strobe) {
+      return; // Dirty range is kept until strobe mode ends
+    }
+
+    uint16_t start = dirtyStart, end = dirtyEnd;
+    uint8_t *buf = dmaBuf;
+    if (dmaBufBack) {
+      // Double-buffered: never touch the buffer being sent
+      if (asyncState != ASYNC_IDLE) {
+        if (!fShowDeferred) {
+          fShowDeferred = true; // Dirty range is kept for the retry
+          framesDeferred++;
+          tDeferred = t_start;
+        }
+        return;
+      }
+      if (fShowDeferred) {
+        fShowDeferred = false;
+        recordWaitTime(t_start - tDeferred);
+      }
+      buf = dmaBufBack;
+      if (lastStart < start)
+        start = lastStart;
+      if (lastEnd > end)
+        end = lastEnd;
+      lastStart = dirtyStart;
+      lastEnd = dirtyEnd;
+    }
+    if (b != limitedBrightness) {
+      // Every byte maps to a new SPI pattern, in both buffers
+      limitedBrightness = b;
+      start = 0;
+      end = numBytes;
+      lastStart = 0;
+      lastEnd = numBytes;
+    }
+
+    if (dirtyStart == 0 && dirtyEnd >= numBytes) {
+      framesFull++;
+    } else {
+      framesPartial++;
+    }
+
+    // Each byte of input (from NeoPixel buffer) is replaced with three bytes
+    // output (from table to DMA buffer). Gamma correction, brightness and the
+    // 3:1 bit expansion are all baked into `expandTable`, see
+    // buildExpandTable(), so there is no per-byte math left to do here.
+    uint8_t *in = pixels + start, *out = buf + start * 3;
     uint32_t expanded;
-    for (uint16_t p = numBytes; p--;) {
-      expanded = bitExpand[(*in++ * brightness) >> 8];
-      *out++ = expanded >> 16; // Shifting 32-bit table entry is
-      *out++ = expanded >> 8;  // about 11% faster than copying
-      *out++ = expanded;       // three values from a uint8_t table.
+    if (b == brightness) {
+      for (uint16_t p = end - start; p--;) {
+        expanded = expandTable[*in++];
+        *out++ = expanded >> 16; // Shifting 32-bit table entry is
+        *out++ = expanded >> 8;  // about 11% faster than copying
+        *out++ = expanded;       // three values from a uint8_t table.
+      }
+    } else {
+      // Power limited: apply the reduced brightness on the fly instead of
+      // rebuilding `expandTable` for a scale that may change every frame
+      framesLimited++;
+      for (uint16_t p = end - start; p--;) {
+        expanded = bitExpand[(gamma8(*in++) * b) >> 8];
+        *out++ = expanded >> 16;
+        *out++ = expanded >> 8;
+        *out++ = expanded;
+      }
+    }
+    dirtyStart = 0xFFFF;
+    dirtyEnd = 0;
+    recordExpandTime(t_start);
+
+    if (dmaBufBack) {
+      // Point the looping descriptor at the back buffer. Takes effect at the
+      // next block boundary, see dmaBlockDone().
+      noInterrupts();
+      dma.changeDescriptor(desc, dmaBufBack);
+      asyncState = ASYNC_PENDING;
+      interrupts();
     }
-#else
-  // If bittable.h is NOT included, 3:1 bit expansion is done on the fly.
-  // More complex, but smaller executable.
-  uint8_t *in = pixels, *out = dmaBuf, i, abef, cdgh;
-  uint32_t expanded;
-  for (uint16_t p = numBytes; p--;) {
-    cdgh = (*in++ * brightness) >> 8;
-    abef = cdgh & 0b11001100; // ab00ef00
-    cdgh &= 0b00110011;       // 00cd00gh
-    expanded = ((abef * 0b1010000010100000) & 0b010010000000010010000000) |
-               ((cdgh * 0b0000101000001010) & 0b000000010010000000010010) |
-               0b100100100100100100100100;
-    *out++ = expanded >> 16;
-    *out++ = expanded >> 8;
-    *out++ = expanded;
-  }
-#endif // !_BITTABLE_H_
 
 #ifdef __SAMD51__
   } else { // NOT using SERCOM DMA technique, expansion is different...
     uint8_t *src = pixels; // Pixel buffer base address from NeoPixel lib
     uint8_t *dst = dmaBuf + EXTRASTARTBYTES;
     uint32_t count = numLEDs * ((wOffset == rOffset) ? 3 : 4); // Bytes/pixel
+    uint32_t t_start = micros();
     while (dma.isActive())
       ; // Wait for DMA callback, so pixel data isn't corrupted
+    recordWaitTime(micros() - t_start);
+    framesFull++; // Always a full frame: every show() restarts the DMA job
+    dirtyStart = 0xFFFF;
+    dirtyEnd = 0;
+    uint16_t b = limitedBrightness = limitBrightness();
+    if (b < brightness)
+      framesLimited++;
     while (count--) {
-      uint8_t byte = (*src++ * brightness) >> 8;
+      uint8_t byte = (gamma8(*src++) * b) >> 8;
       for (uint8_t bit = 0x80; bit; bit >>= 1) {
         *dst++ = toggleMask; // Initial toggle high
         if (byte & bit) {
@@ -431,7 +593,44 @@ void Adafruit_NeoPixel_ZeroDMA::show(void) {
     @param b 0 - 255 brightness value
 */
 void Adafruit_NeoPixel_ZeroDMA::setBrightness(uint8_t b) {
-  brightness = (uint16_t)b + 1; // 0-255 in, 1-256 out
+  if (brightness != (uint16_t)b + 1) {
+    brightness = (uint16_t)b + 1; // 0-255 in, 1-256 out
+    buildExpandTable();
+    invalidate(); // All pixels map to new SPI patterns
+    limitedBrightness = limitBrightness();
+    if (dither)
+      updateDitherLevels(0, numBytes);
+    if (strobeOn) {
+      expandSolid(strobeOn, strobeOnColor);
+      expandSolid(strobeOff, strobeOffColor);
+    }
+  }
+}
+
+/** @brief Rebuild the lookup table used by show(). Each entry holds the
+    3:1 bit expansion of the gamma-corrected pixel byte scaled by the
+    current brightness. Brightness scales linear light, i.e. it is applied
+    after gamma correction, so fades stay perceptually even at any
+    brightness setting.
+*/
+void Adafruit_NeoPixel_ZeroDMA::buildExpandTable(void) {
+  for (uint16_t i = 0; i < 256; i++) {
+    // Expand 8 bits 'abcdefgh' to 24 bits '1a01b01c01d01e01f01g01h0'
+    uint8_t level = (gamma8(i) * brightness) >> 8;
+#ifdef _BITTABLE_H_
+    // If bittable.h is included, 3:1 bit expansion is handled using a table
+    // lookup, else it is done on the fly. Either way it only runs when the
+    // brightness changes.
+    expandTable[i] = bitExpand[level];
+#else
+    uint8_t abef = level & 0b11001100; // ab00ef00
+    uint8_t cdgh = level & 0b00110011; // 00cd00gh
+    expandTable[i] =
+        ((abef * 0b1010000010100000) & 0b010010000000010010000000) |
+        ((cdgh * 0b0000101000001010) & 0b000000010010000000010010) |
+        0b100100100100100100100100;
+#endif
+  }
 }
 
 /** @brief The brightness, back adjusted to 0-255 standard expectation
@@ -439,3 +638,409 @@ void Adafruit_NeoPixel_ZeroDMA::setBrightness(uint8_t b) {
 uint8_t Adafruit_NeoPixel_ZeroDMA::getBrightness(void) const {
   return brightness - 1; // 1-256 in, 0-255 out
 }
+
+/** @brief Store one pixel and extend the dirty range when its value changed.
+    Stores the values as-is: brightness is applied in show().
+    @param n Pixel index
+    @param r Red
+    @param g Green
+    @param b Blue
+    @param w White, ignored for RGB strips
+*/
+void Adafruit_NeoPixel_ZeroDMA::storePixel(uint16_t n, uint8_t r, uint8_t g,
+                                           uint8_t b, uint8_t w) {
+  uint8_t *p;
+  uint16_t first;
+  if (wOffset == rOffset) { // Is an RGB-type strip
+    first = n * 3;
+    p = &pixels[first];
+    if ((p[rOffset] == r) && (p[gOffset] == g) && (p[bOffset] == b))
+      return;
+    markDirty(first, first + 3);
+    powerSum += gamma8(r) + gamma8(g) + gamma8(b);
+    powerSum -= gamma8(p[rOffset]) + gamma8(p[gOffset]) + gamma8(p[bOffset]);
+  } else { // Is a WRGB-type strip
+    first = n * 4;
+    p = &pixels[first];
+    if ((p[rOffset] == r) && (p[gOffset] == g) && (p[bOffset] == b) &&
+        (p[wOffset] == w))
+      return;
+    markDirty(first, first + 4);
+    powerSum += gamma8(r) + gamma8(g) + gamma8(b) + gamma8(w);
+    powerSum -= gamma8(p[rOffset]) + gamma8(p[gOffset]) + gamma8(p[bOffset]) +
+                gamma8(p[wOffset]);
+    p[wOffset] = w;
+  }
+  p[rOffset] = r;
+  p[gOffset] = g;
+  p[bOffset] = b;
+}
+
+/** @brief Set a pixel's color from separate R, G, B components. The white
+    element of RGBW pixels is set to 0.
+    @param n Pixel index, starting from 0
+    @param r Red
+    @param g Green
+    @param b Blue
+*/
+void Adafruit_NeoPixel_ZeroDMA::setPixelColor(uint16_t n, uint8_t r, uint8_t g,
+                                              uint8_t b) {
+  if (n < numLEDs)
+    storePixel(n, r, g, b, 0);
+}
+
+/** @brief Set a pixel's color from separate R, G, B, W components
+    @param n Pixel index, starting from 0
+    @param r Red
+    @param g Green
+    @param b Blue
+    @param w White, ignored for RGB strips
+*/
+void Adafruit_NeoPixel_ZeroDMA::setPixelColor(uint16_t n, uint8_t r, uint8_t g,
+                                              uint8_t b, uint8_t w) {
+  if (n < numLEDs)
+    storePixel(n, r, g, b, w);
+}
+
+/** @brief Set a pixel's color from a packed 32-bit WRGB value
+    @param n Pixel index, starting from 0
+    @param c Packed color, see Color()
+*/
+void Adafruit_NeoPixel_ZeroDMA::setPixelColor(uint16_t n, uint32_t c) {
+  if (n < numLEDs)
+    storePixel(n, (uint8_t)(c >> 16), (uint8_t)(c >> 8), (uint8_t)c,
+               (uint8_t)(c >> 24));
+}
+
+/** @brief Fill all or part of the strip with a color
+    @param c Packed color, see Color()
+    @param first Index of first pixel to fill
+    @param count Number of pixels to fill, 0 fills to the end of the strip
+*/
+void Adafruit_NeoPixel_ZeroDMA::fill(uint32_t c, uint16_t first,
+                                     uint16_t count) {
+  uint16_t i, end;
+
+  if (first >= numLEDs)
+    return;
+  end = ((count == 0) || (first + count > numLEDs)) ? numLEDs : first + count;
+  for (i = first; i < end; i++)
+    setPixelColor(i, c);
+}
+
+/** @brief Set all pixels to 'off' */
+void Adafruit_NeoPixel_ZeroDMA::clear(void) { fill(0); }
+
+/** @brief Limit the estimated current drawn by the LEDs
+    @param milliamps Maximum current [mA], 0 to disable the limiter
+    @param channelMilliamps Current of one color channel at full duty [mA]
+*/
+void Adafruit_NeoPixel_ZeroDMA::setPowerLimit(uint16_t milliamps,
+                                              uint8_t channelMilliamps) {
+  // Express the limit as a sum of gamma8() values at full brightness, so
+  // that show() needs no unit conversion
+  powerLimit =
+      channelMilliamps ? (uint32_t)milliamps * 255 / channelMilliamps : 0;
+  invalidate();
+}
+
+/** @brief Recalculate the power estimate over all pixel bytes */
+void Adafruit_NeoPixel_ZeroDMA::sumPower(void) {
+  uint32_t sum = 0;
+  if (pixels) {
+    for (uint16_t i = 0; i < numBytes; i++)
+      sum += gamma8(pixels[i]);
+  }
+  powerSum = sum;
+}
+
+/** @brief The brightness to show the current pixels with
+    @returns `brightness`, or lower when the power limit would be exceeded
+*/
+uint16_t Adafruit_NeoPixel_ZeroDMA::limitBrightness(void) const {
+  // powerSum <= 255 * 65535, so neither product overflows
+  if (!powerLimit || ((powerSum * brightness) >> 8) <= powerLimit)
+    return brightness;
+  uint16_t b = (powerLimit << 8) / powerSum; // < brightness
+  return b ? b : 1;
+}
+
+/** @brief Reset the frame counters of show() */
+void Adafruit_NeoPixel_ZeroDMA::resetFrameCounters(void) {
+  framesFull = 0;
+  framesPartial = 0;
+  framesSkipped = 0;
+  framesLatched = 0;
+  framesDithered = 0;
+  framesDeferred = 0;
+  framesLimited = 0;
+  strobeFlashes = 0;
+  expandCount = 0;
+  expandTime = 0;
+  expandTimeMax = 0;
+  waitCount = 0;
+  waitTime = 0;
+  waitTimeMax = 0;
+}
+
+/** @brief Enable or disable double-buffered mode. Must be called before
+    begin(), as it doubles the size of the DMA buffer allocation.
+    @param enable True to double buffer
+*/
+void Adafruit_NeoPixel_ZeroDMA::setDoubleBuffer(bool enable) {
+  if (!dmaMem)
+    doubleBuffer = enable;
+}
+
+/** @brief Set a function to be called, from interrupt context, each time a
+    frame has been latched in double-buffered mode
+    @param cb Callback, or NULL to disable
+*/
+void Adafruit_NeoPixel_ZeroDMA::setLatchCallback(
+    void (*cb)(Adafruit_NeoPixel_ZeroDMA *)) {
+  latchCallback = cb;
+}
+
+/** @brief Let the looping descriptor interrupt at the end of every pass
+    over the buffer, which is where a changed source address takes effect,
+    and route the interrupt to this strip
+*/
+void Adafruit_NeoPixel_ZeroDMA::enableBlockInterrupt(void) {
+  desc->BTCTRL.bit.BLOCKACT = DMA_BLOCK_ACTION_INT;
+  instances[dma.getChannel()] = this;
+  dma.setCallback(dmaBlockCallback);
+}
+
+/** @brief DMA callback, dispatches to the strip that owns the channel
+    @param dma The DMA manager that completed a block
+*/
+void Adafruit_NeoPixel_ZeroDMA::dmaBlockCallback(Adafruit_ZeroDMA *dma) {
+  uint8_t channel = dma->getChannel();
+  if ((channel < DMAC_CH_NUM) && instances[channel])
+    instances[channel]->dmaBlockDone();
+}
+
+/** @brief Called from interrupt context at the end of every pass over the
+    DMA buffer. Advances the state of a pending frame and swaps the buffers
+    once the new frame has surely been sent, latch included.
+*/
+void Adafruit_NeoPixel_ZeroDMA::dmaBlockDone(void) {
+  if (strobe) {
+    if (strobePasses && (--strobePasses == 0))
+      dma.changeDescriptor(desc, strobeOff);
+    return;
+  }
+
+  switch (asyncState) {
+  case ASYNC_PENDING:
+    asyncState = ASYNC_ARMED;
+    break;
+  case ASYNC_ARMED:
+    asyncState = ASYNC_SENDING;
+    break;
+  case ASYNC_SENDING: {
+    uint8_t *tmp = dmaBuf;
+    dmaBuf = dmaBufBack;
+    dmaBufBack = tmp;
+    framesLatched++;
+    asyncState = ASYNC_IDLE;
+    if (latchCallback)
+      latchCallback(this);
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+/** @brief Enter or leave strobe mode. The 'on' and 'off' frames are
+    allocated at the first call, see allocMem().
+    @param enable True to enter strobe mode
+    @returns False when not begun yet or out of memory
+*/
+bool Adafruit_NeoPixel_ZeroDMA::setStrobe(bool enable) {
+  if (!desc)
+    return false;
+
+  if (enable && !strobeOn) {
+    uint32_t bytesTotal = numBytes * 3 + 90; // Same as in begin()
+    if (!(strobeOn =
+              allocMem(staticStrobeMem, staticStrobeSize, bytesTotal * 2)))
+      return false;
+    strobeOff = strobeOn + bytesTotal;
+    memset(strobeOn, 0, bytesTotal * 2); // Latch data @ end
+    expandSolid(strobeOn, strobeOnColor);
+    expandSolid(strobeOff, strobeOffColor);
+    enableBlockInterrupt();
+  }
+
+  noInterrupts();
+  if (enable) {
+    strobePasses = 0;
+    asyncState = ASYNC_IDLE; // Drops a pending frame, redrawn afterwards
+    dma.changeDescriptor(desc, strobeOff);
+  } else if (strobe) {
+    dma.changeDescriptor(desc, dmaBuf);
+  }
+  strobe = enable;
+  interrupts();
+
+  if (!enable) {
+    invalidate(); // Redraw whatever was shown during strobe mode
+    lastStart = 0;
+    lastEnd = numBytes;
+  }
+  return true;
+}
+
+/** @brief Set the solid colors of the strobe frames
+    @param on Packed color of a flash
+    @param off Packed color in between flashes
+*/
+void Adafruit_NeoPixel_ZeroDMA::setStrobeColors(uint32_t on, uint32_t off) {
+  strobeOnColor = on;
+  strobeOffColor = off;
+  if (strobeOn) {
+    // Not while the frame is being sent
+    if (!strobe || !strobePasses)
+      expandSolid(strobeOn, on);
+    expandSolid(strobeOff, off);
+  }
+}
+
+/** @brief Start a flash. Only rewrites the DMA source address, so it is
+    cheap enough to call right after a step.
+    @param passes Minimum number of passes over the DMA buffer to keep the
+    'on' frame. A pass takes 10 us per pixel byte plus the 300 us latch.
+*/
+void Adafruit_NeoPixel_ZeroDMA::strobeFlash(uint8_t passes) {
+  if (!strobe)
+    return;
+  noInterrupts();
+  dma.changeDescriptor(desc, strobeOn);
+  // One extra pass: the next pass boundary may already have passed
+  strobePasses = passes + 1;
+  interrupts();
+  strobeFlashes++;
+}
+
+/** @brief Expand a solid color into a DMA buffer
+    @param buf DMA buffer
+    @param color Packed color, white is ignored for RGB strips
+*/
+void Adafruit_NeoPixel_ZeroDMA::expandSolid(uint8_t *buf, uint32_t color) {
+  uint8_t bytesPerPixel = (wOffset == rOffset) ? 3 : 4;
+  uint8_t px[4];
+  px[rOffset] = (uint8_t)(color >> 16);
+  px[gOffset] = (uint8_t)(color >> 8);
+  px[bOffset] = (uint8_t)color;
+  if (bytesPerPixel == 4)
+    px[wOffset] = (uint8_t)(color >> 24);
+
+  uint32_t expanded;
+  for (uint16_t i = 0; i < numBytes; i++) {
+    expanded = expandTable[px[i % bytesPerPixel]];
+    *buf++ = expanded >> 16;
+    *buf++ = expanded >> 8;
+    *buf++ = expanded;
+  }
+}
+
+/** @brief Start or stop temporal dithering. The 16-bit levels are
+    allocated at the first call, see allocMem().
+    @param enable True to dither
+    @returns False when not double-buffered, not begun yet or out of memory
+*/
+bool Adafruit_NeoPixel_ZeroDMA::setDither(bool enable) {
+  if (!dmaBufBack)
+    return false;
+
+  if (enable && !ditherLevels) {
+    // One allocation: 16-bit levels first, for alignment
+    if (!(ditherLevels = (uint16_t *)allocMem(staticDitherMem,
+                                              staticDitherSize, numBytes * 3)))
+      return false;
+    ditherAcc = (uint8_t *)(ditherLevels + numBytes);
+    memset(ditherAcc, 0, numBytes);
+  }
+  if (enable && !dither)
+    updateDitherLevels(0, numBytes);
+  dither = enable;
+
+  // The back buffer no longer matches the dirty ranges in either direction
+  invalidate();
+  lastStart = 0;
+  lastEnd = numBytes;
+  return true;
+}
+
+/** @brief Recalculate the 16-bit levels of a range of pixel bytes
+    @param start First pixel byte
+    @param end One past the last pixel byte
+*/
+void Adafruit_NeoPixel_ZeroDMA::updateDitherLevels(uint16_t start,
+                                                   uint16_t end) {
+  uint8_t *in = pixels + start;
+  uint16_t *out = ditherLevels + start;
+  for (uint16_t p = end - start; p--;) {
+    *out++ = ((uint32_t)gamma16Table[*in++] * limitedBrightness) >> 8;
+  }
+}
+
+/** @brief Put out the next dithered frame when the previous one has been
+    latched, else return at once. Call as often as possible: the frame rate
+    is paced by the DMA completion callback, see dmaBlockDone().
+    @returns True when a frame was put out
+*/
+bool Adafruit_NeoPixel_ZeroDMA::ditherFrame(void) {
+  if (!dither || strobe || (asyncState != ASYNC_IDLE))
+    return false;
+
+  // First-order sigma-delta per pixel byte: the fraction accumulates and
+  // carries into the integer part once it overflows, so over 256 frames the
+  // average output level equals the 16-bit level
+  uint32_t t_start = micros();
+  uint16_t *lv = ditherLevels;
+  uint8_t *acc = ditherAcc, *out = dmaBufBack;
+  uint16_t level, sum, value;
+  uint32_t expanded;
+  for (uint16_t p = numBytes; p--;) {
+    level = *lv++;
+    sum = *acc + (level & 0xFF);
+    *acc++ = sum;
+    value = (level >> 8) + (sum >> 8);
+    expanded = bitExpand[value > 255 ? 255 : value];
+    *out++ = expanded >> 16;
+    *out++ = expanded >> 8;
+    *out++ = expanded;
+  }
+  recordExpandTime(t_start);
+
+  noInterrupts();
+  dma.changeDescriptor(desc, dmaBufBack);
+  asyncState = ASYNC_PENDING;
+  interrupts();
+  framesDithered++;
+  return true;
+}
+
+/** @brief Account for the time spent expanding a frame
+    @param t_start micros() at the start of the expansion
+*/
+void Adafruit_NeoPixel_ZeroDMA::recordExpandTime(uint32_t t_start) {
+  uint32_t dt = micros() - t_start;
+  expandCount++;
+  expandTime += dt;
+  if (dt > expandTimeMax)
+    expandTimeMax = dt;
+}
+
+/** @brief Account for the time a frame waited on the DMA
+    @param dt Time waited [us]
+*/
+void Adafruit_NeoPixel_ZeroDMA::recordWaitTime(uint32_t dt) {
+  waitCount++;
+  waitTime += dt;
+  if (dt > waitTimeMax)
+    waitTimeMax = dt;
+}
@@ -30,17 +30,200 @@ public:
   void show();
   void setBrightness(uint8_t);
   uint8_t getBrightness() const;
+
+  // These hide the (non-virtual) base class functions to keep track of the
+  // range of pixel bytes that changed since the last show(). Writes that do
+  // not change a value are not counted as a change.
+  void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b);
+  void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b, uint8_t w);
+  void setPixelColor(uint16_t n, uint32_t c);
+  void fill(uint32_t c = 0, uint16_t first = 0, uint16_t count = 0);
+  void clear(void);
+  /**
+   * @brief Mark the whole strip as changed. Call this after writing to the
+   * buffer returned by getPixels() directly. */
+  inline void invalidate(void) {
+    sumPower();
+    markDirty(0, numBytes);
+  }
+
+  // Power limiter. Estimates the current drawn by the LEDs from the
+  // gamma-corrected pixel values and the brightness, and when that exceeds
+  // the limit, show() scales the brightness of the frame down to fit. The
+  // estimate is kept up to date as pixels change, so checking it costs next
+  // to nothing per frame. The quiescent current of the pixels is not
+  // included, nor are the solid frames of strobe mode.
+  void setPowerLimit(uint16_t milliamps, uint8_t channelMilliamps = 20);
+  /** @brief Frames shown at reduced brightness by the power limiter */
+  inline uint32_t getFramesLimited(void) const { return framesLimited; }
+  /** @brief Brightness the frames are expanded with, 0-255. Lower than
+      getBrightness() while the power limiter is active. */
+  inline uint8_t getLimitedBrightness(void) const {
+    return limitedBrightness - 1;
+  }
+
+  /** @brief Frame counters of show(), see resetFrameCounters() */
+  inline uint32_t getFramesFull(void) const { return framesFull; }
+  inline uint32_t getFramesPartial(void) const { return framesPartial; }
+  inline uint32_t getFramesSkipped(void) const { return framesSkipped; }
+  /** @brief Frames shown while the previous one was still pending */
+  inline uint32_t getFramesDeferred(void) const { return framesDeferred; }
+  /** @brief Frame expansions by show() and ditherFrame(), and the total and
+      maximum time [us] spent on them */
+  inline uint32_t getExpandCount(void) const { return expandCount; }
+  inline uint32_t getExpandTime(void) const { return expandTime; }
+  inline uint32_t getExpandTimeMax(void) const { return expandTimeMax; }
+  /** @brief Frames that waited on the DMA before being expanded, and the
+      total and maximum time [us] they waited. In double-buffered mode this
+      is the time from a deferred show() until its successful retry, else
+      only the SAMD51 port-toggle path waits. */
+  inline uint32_t getWaitCount(void) const { return waitCount; }
+  inline uint32_t getWaitTime(void) const { return waitTime; }
+  inline uint32_t getWaitTimeMax(void) const { return waitTimeMax; }
+  void resetFrameCounters(void);
+
+  // Double-buffered mode, must be set before begin(). show() then renders
+  // into a back buffer while the DMA keeps sending the front buffer, and the
+  // buffers swap once the DMA has picked up the new frame. A show() call
+  // while a frame is still pending does not block: it is deferred and
+  // should be repeated once canShow() returns true, see showDeferred().
+  void setDoubleBuffer(bool enable);
+  void setLatchCallback(void (*cb)(Adafruit_NeoPixel_ZeroDMA *));
   /**
-   * @brief Override NeoPixel canShow, this always returns true because we
-   * double buffer
-   * @returns True always */
-  inline bool canShow(void) { return true; }
+   * @brief Override NeoPixel canShow
+   * @returns Always true in single-buffered mode. In double-buffered mode,
+   * true when no frame is pending, i.e. show() will not be deferred. */
+  inline bool canShow(void) { return asyncState == ASYNC_IDLE; }
+  /** @brief True while a shown frame has not been latched yet */
+  inline bool showPending(void) const { return asyncState != ASYNC_IDLE; }
+  /** @brief True when a show() call was deferred and must be repeated */
+  inline bool showDeferred(void) const { return fShowDeferred; }
+  /** @brief Number of frames latched in double-buffered mode */
+  inline uint32_t getFramesLatched(void) const { return framesLatched; }
+
+  // Strobe mode, call after begin(). The DMA then loops over a pre-expanded
+  // solid 'off' frame, and strobeFlash() swaps in a pre-expanded 'on' frame
+  // by only rewriting the DMA source address. The flash reaches the wire at
+  // the next pass boundary, i.e. within one pass over the DMA buffer. Frames
+  // shown in the meantime are kept and appear once strobe mode ends.
+  bool setStrobe(bool enable);
+  void setStrobeColors(uint32_t on, uint32_t off = 0);
+  void strobeFlash(uint8_t passes = 1);
+  /** @brief True while in strobe mode */
+  inline bool strobing(void) const { return strobe; }
+  /** @brief Number of flashes started, see resetFrameCounters() */
+  inline uint32_t getStrobeFlashes(void) const { return strobeFlashes; }
+
+  // Temporal dithering, requires double-buffered mode and begin(). Keeps a
+  // 16-bit level per pixel byte, gamma correction and brightness applied,
+  // and spreads its fractional part over consecutive frames. show() then
+  // only updates those levels, and ditherFrame() puts out the next frame.
+  bool setDither(bool enable);
+  bool ditherFrame(void);
+  /** @brief True while dithering */
+  inline bool dithering(void) const { return dither; }
+  /** @brief Number of dithered frames put out */
+  inline uint32_t getFramesDithered(void) const { return framesDithered; }
 
 protected:
   Adafruit_ZeroDMA dma; ///< The DMA manager for the SPI class
   SPIClassSAMD *spi;    ///< Underlying SPI hardware interface we use to DMA
   uint8_t *dmaBuf;      ///< The raw buffer we write to SPI to mimic NeoPixel
+  uint8_t *dmaBufBack;  ///< Back buffer in double-buffered mode, else NULL
+  uint8_t *dmaMem;      ///< Allocation holding dmaBuf and dmaBufBack
+  uint8_t *staticDmaMem;  ///< Static memory for dmaMem, see allocDmaMem()
+  uint32_t staticDmaSize; ///< Size of staticDmaMem
+  uint8_t *staticStrobeMem;  ///< Static memory for the strobe frames
+  uint32_t staticStrobeSize; ///< Size of staticStrobeMem
+  uint8_t *staticDitherMem;  ///< Static memory for the dither levels
+  uint32_t staticDitherSize; ///< Size of staticDitherMem
+  static uint8_t *allocMem(uint8_t *staticMem, uint32_t staticSize,
+                           uint32_t size);
+  uint8_t *allocDmaMem(uint32_t size);
+  void freeDmaMem(void);
   uint16_t brightness;  ///<  1 (off) to 256 (brightest)
+  /// Maps a pixel byte straight to its 3-byte SPI pattern, with gamma
+  /// correction and brightness fused in. Rebuilt by setBrightness().
+  uint32_t expandTable[256];
+  void buildExpandTable(void);
+
+  /// Range of pixel bytes [dirtyStart, dirtyEnd) changed since the last
+  /// show(). Empty when dirtyStart >= dirtyEnd.
+  uint16_t dirtyStart;
+  uint16_t dirtyEnd;
+  inline void markDirty(uint16_t start, uint16_t end) {
+    if (start < dirtyStart)
+      dirtyStart = start;
+    if (end > dirtyEnd)
+      dirtyEnd = end;
+  }
+  void storePixel(uint16_t n, uint8_t r, uint8_t g, uint8_t b, uint8_t w);
+
+  // Power limiter, see setPowerLimit()
+  uint32_t powerSum;   ///< Sum of gamma8() over all pixel bytes
+  uint32_t powerLimit; ///< Maximum powerSum at full brightness, 0: no limit
+  uint16_t limitedBrightness; ///< 1 (off) to 256, at most `brightness`
+  uint32_t framesLimited;
+  void sumPower(void);
+  uint16_t limitBrightness(void) const;
+
+  uint32_t framesFull;    ///< show() calls that expanded all bytes
+  uint32_t framesPartial; ///< show() calls that expanded part of the bytes
+  uint32_t framesSkipped; ///< show() calls without any change
+
+  // Double buffering. A new source address in the looping descriptor only
+  // takes effect at the next block boundary, and a boundary interrupt can
+  // race the address write. Hence a frame is only considered latched after
+  // three boundaries: PENDING -> ARMED -> SENDING -> IDLE.
+  enum {
+    ASYNC_IDLE,    ///< Back buffer is free to render into
+    ASYNC_PENDING, ///< Descriptor points to the back buffer
+    ASYNC_ARMED,   ///< Back buffer is being or about to be sent
+    ASYNC_SENDING  ///< Back buffer is surely being sent
+  };
+  bool doubleBuffer;
+  bool fShowDeferred;
+  volatile uint8_t asyncState;
+  volatile uint32_t framesLatched;
+  DmacDescriptor *desc; ///< The looping descriptor of `dma`
+  /// Dirty range of the previous frame. The back buffer lags one frame
+  /// behind, so it needs the union of both ranges re-expanded.
+  uint16_t lastStart;
+  uint16_t lastEnd;
+  void (*latchCallback)(Adafruit_NeoPixel_ZeroDMA *);
+
+  // Strobe mode
+  bool strobe;
+  uint8_t *strobeOn;  ///< Pre-expanded 'on' frame, latch included
+  uint8_t *strobeOff; ///< Pre-expanded 'off' frame, latch included
+  uint32_t strobeOnColor;
+  uint32_t strobeOffColor;
+  volatile uint8_t strobePasses; ///< Passes left before reverting to 'off'
+  uint32_t strobeFlashes;
+  void expandSolid(uint8_t *buf, uint32_t color);
+  void enableBlockInterrupt(void);
+
+  // Temporal dithering
+  bool dither;
+  uint16_t *ditherLevels; ///< Per pixel byte, 8.8 fixed point
+  uint8_t *ditherAcc;     ///< Per pixel byte, accumulated fraction
+  uint32_t framesDithered;
+  void updateDitherLevels(uint16_t start, uint16_t end);
+
+  // Instrumentation, see getExpandTime() and getWaitTime()
+  uint32_t framesDeferred;
+  uint32_t tDeferred; ///< micros() at the first deferral of a frame
+  uint32_t expandCount;
+  uint32_t expandTime;
+  uint32_t expandTimeMax;
+  uint32_t waitCount;
+  uint32_t waitTime;
+  uint32_t waitTimeMax;
+  void recordExpandTime(uint32_t t_start);
+  void recordWaitTime(uint32_t dt);
+  void dmaBlockDone(void);
+  static void dmaBlockCallback(Adafruit_ZeroDMA *dma);
+  static Adafruit_NeoPixel_ZeroDMA *instances[DMAC_CH_NUM]; ///< By channel
 #ifdef __SAMD51__
   // Hacky stuff for Trellis M4: PA27 (to NeoPixel matrix) is not on a
   // SERCOM, nor a pattern generator pin (which would work with NeoPXL8),
@@ -51,4 +234,54 @@ protected:
 #endif
 };
 
+/** @brief Adafruit_NeoPixel_ZeroDMA with its pixel and DMA buffers in
+    static storage instead of on the heap, sized at compile time by the
+    number of pixels `N` and the color order `TYPE`, e.g. NEO_GRBW. The RAM
+    is accounted for at link time, and begin() cannot run out of memory.
+    The DMA memory always fits double-buffered mode, and the strobe frames
+    and dither levels have their own static buffers as well.
+
+    Usage: Adafruit_NeoPixel_ZeroDMA_Static<16, NEO_GRBW> strip(5);
+*/
+template <uint16_t N, neoPixelType TYPE>
+class Adafruit_NeoPixel_ZeroDMA_Static : public Adafruit_NeoPixel_ZeroDMA {
+public:
+  /// Bytes per pixel: RGB types have the white offset equal to red's
+  static constexpr uint8_t BYTES_PER_PIXEL =
+      (((TYPE >> 6) & 0b11) == ((TYPE >> 4) & 0b11)) ? 3 : 4;
+  static constexpr uint16_t NUM_BYTES = N * BYTES_PER_PIXEL;
+  /// DMA buffer size, same as calculated in begin()
+  static constexpr uint32_t DMA_BYTES = NUM_BYTES * 3 + 90;
+
+  static_assert(N > 0, "A strip needs at least one pixel");
+  static_assert(DMA_BYTES <= 0xFFFF, "Strip too long for one DMA transfer");
+
+  /** @brief Create a strip using static buffers
+      @param p Pin to use */
+  Adafruit_NeoPixel_ZeroDMA_Static(uint8_t p = 6)
+      : Adafruit_NeoPixel_ZeroDMA() {
+    updateType(TYPE); // `pixels` is still NULL, so nothing gets allocated
+    pin = p;
+    numLEDs = N;
+    numBytes = NUM_BYTES;
+    pixels = staticPixels;
+    staticDmaMem = staticDma;
+    staticDmaSize = sizeof(staticDma);
+    staticStrobeMem = staticStrobe;
+    staticStrobeSize = sizeof(staticStrobe);
+    staticDitherMem = (uint8_t *)staticDither;
+    staticDitherSize = sizeof(staticDither);
+  }
+
+  ~Adafruit_NeoPixel_ZeroDMA_Static() {
+    pixels = NULL; // Not on the heap, keep ~Adafruit_NeoPixel() from freeing
+  }
+
+private:
+  uint8_t staticPixels[NUM_BYTES] = {0};
+  uint8_t staticDma[DMA_BYTES * 2];
+  uint8_t staticStrobe[DMA_BYTES * 2]; // 'On' and 'off' frames
+  uint16_t staticDither[(NUM_BYTES * 3 + 1) / 2]; // Levels, then accumulators
+};
+
 #endif // _ADAFRUIT_NEOPIXEL_ZERODMA_H_
@@ -705,3 +705,22 @@ void Adafruit_ZeroDMA::printStatus(ZeroDMAstatus s) {
 bool Adafruit_ZeroDMA::isActive() {
   return _writeback[channel].BTCTRL.bit.VALID;
 }
+
+#ifndef __SAMD51__
+uint16_t Adafruit_ZeroDMA::crc16(const uint8_t *data, uint32_t len,
+                                 uint16_t crc) {
+  // CRCCTRL may only be written while the CRC engine is disabled
+  DMAC->CTRL.bit.CRCENABLE = 0;
+  DMAC->CRCCTRL.reg = DMAC_CRCCTRL_CRCBEATSIZE_BYTE |
+                      DMAC_CRCCTRL_CRCPOLY_CRC16 | DMAC_CRCCTRL_CRCSRC_IO;
+  DMAC->CRCCHKSUM.reg = crc;
+  DMAC->CTRL.bit.CRCENABLE = 1;
+  while (len--) {
+    DMAC->CRCDATAIN.reg = *data++; // One clock cycle per byte
+  }
+  crc = DMAC->CRCCHKSUM.reg;
+  DMAC->CRCSTATUS.reg = DMAC_CRCSTATUS_CRCBUSY; // Cleared by writing one
+  DMAC->CTRL.bit.CRCENABLE = 0;
+  return crc;
+}
+#endif
@@ -233,6 +233,22 @@ public:
   */
   bool isActive();
 
+#ifndef __SAMD51__
+  /*!
+    @brief   Calculate a CRC-16 (CRC-CCITT, polynomial 0x1021) over a buffer
+             with the CRC engine of the DMA controller, fed by the CPU
+             through its I/O interface. Independent of any channel, but the
+             DMA controller must have been initialized by a first call to
+             allocate(), which also resets the CRC engine.
+    @param   data  Buffer.
+    @param   len   Number of bytes.
+    @param   crc   Initial value of the checksum.
+    @return  uint16_t  The checksum.
+  */
+  static uint16_t crc16(const uint8_t *data, uint32_t len,
+                        uint16_t crc = 0xFFFF);
+#endif
+
 protected:
   uint8_t channel; ///< DMA channel index (0 to DMAC_CH_NUM-1, or 0xFF)
   volatile enum ZeroDMAstatus jobStatus; ///< Last known DMA job status
@@ -0,0 +1,102 @@
+#include "DvG_BinaryFrame.h"
+
+#if defined(ARDUINO_ARCH_SAMD) && !defined(__SAMD51__)
+#  include <Adafruit_ZeroDMA.h>
+#  define DVG_CRC_DMAC
+#endif
+
+static bool crc_hw = false;
+
+// CRC-16/CCITT-FALSE of the nibbles 0x0 to 0xF: a 32-byte table at half the
+// speed of a 512-byte one
+static const uint16_t crc_nibble[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF};
+
+uint16_t dvgCrc16Soft(const uint8_t *data, uint16_t len, uint16_t crc) {
+  while (len--) {
+    crc = (crc << 4) ^ crc_nibble[(crc >> 12) ^ (*data >> 4)];
+    crc = (crc << 4) ^ crc_nibble[(crc >> 12) ^ (*data & 0x0F)];
+    data++;
+  }
+  return crc;
+}
+
+bool dvgCrc16Begin() {
+#ifdef DVG_CRC_DMAC
+  // Standard check input, CRC-16/CCITT-FALSE gives 0x29B1
+  static const uint8_t check[9] = {'1', '2', '3', '4', '5',
+                                   '6', '7', '8', '9'};
+  crc_hw = (Adafruit_ZeroDMA::crc16(check, sizeof(check)) ==
+            dvgCrc16Soft(check, sizeof(check)));
+#endif
+  return crc_hw;
+}
+
+bool dvgCrc16Hardware() { return crc_hw; }
+
+uint16_t dvgCrc16(const uint8_t *data, uint16_t len) {
+#ifdef DVG_CRC_DMAC
+  if (crc_hw) {
+    return Adafruit_ZeroDMA::crc16(data, len);
+  }
+#endif
+  return dvgCrc16Soft(data, len);
+}
+
+uint16_t dvgFrameEncode(const uint8_t *payload, uint16_t len, uint8_t *out) {
+  uint16_t crc = dvgCrc16(payload, len);
+  uint8_t *dst = out;
+  uint8_t *code_ptr;
+  uint8_t code = 1;
+  uint8_t c;
+
+  *dst++ = 0x00;
+  code_ptr = dst++;
+  for (uint16_t i = 0; i < len + 2; i++) {
+    c = (i < len ? payload[i] : i == len ? crc >> 8 : crc & 0xFF);
+    if (c == 0) {
+      *code_ptr = code;
+      code_ptr = dst++;
+      code = 1;
+    } else {
+      *dst++ = c;
+      if (++code == 0xFF) {
+        *code_ptr = code;
+        code_ptr = dst++;
+        code = 1;
+      }
+    }
+  }
+  *code_ptr = code;
+  *dst++ = 0x00;
+  return dst - out;
+}
+
+int16_t dvgFrameDecode(uint8_t *buf, uint16_t len) {
+  uint16_t r = 0; // Read index
+  uint16_t w = 0; // Write index, always behind `r`
+  uint8_t code;
+
+  while (r < len) {
+    code = buf[r++];
+    if (code == 0 || r + code - 1 > len) {
+      return -1;
+    }
+    for (uint8_t i = 1; i < code; i++) {
+      buf[w++] = buf[r++];
+    }
+    if (code < 0xFF && r < len) {
+      buf[w++] = 0;
+    }
+  }
+
+  if (w < 2) {
+    return -1;
+  }
+  w -= 2;
+  if (dvgCrc16(buf, w) != (uint16_t)((buf[w] << 8) | buf[w + 1])) {
+    return -1;
+  }
+  return w;
+}
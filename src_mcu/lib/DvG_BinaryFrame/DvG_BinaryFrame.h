@@ -0,0 +1,55 @@
+/*
+Binary frames for streaming setpoints and bulk parameter updates over the
+serial port, next to the newline-terminated ASCII commands. On the wire a
+frame looks like
+
+  0x00  COBS(payload, crc_hi, crc_lo)  0x00
+
+COBS (Consistent Overhead Byte Stuffing) removes every 0x00 from the encoded
+bytes at a cost of one byte per 254, so 0x00 only ever appears as the frame
+delimiter. ASCII commands never contain 0x00, which lets a receiver tell both
+apart by the very first byte, see `DvG_SerialCommand::available()`.
+
+The CRC is CRC-16/CCITT-FALSE: polynomial 0x1021, initial value 0xFFFF, no
+reflection and no final XOR, over the payload. On the SAMD21 it is calculated
+by the CRC engine of the DMA controller, once `dvgCrc16Begin()` verified
+that the engine agrees with the software implementation.
+
+Arduino-free on purpose, so that the host tools can include it.
+*/
+
+#ifndef DvG_BinaryFrame_h
+#define DvG_BinaryFrame_h
+
+#include <stdint.h>
+
+// Maximum payload [bytes] of a frame
+#define DVG_FRAME_PAYLOAD 60
+
+// Maximum size [bytes] of an encoded frame, delimiters included
+#define DVG_FRAME_ENCODED(payload_len) \
+  ((payload_len) + 5 + ((payload_len) + 2) / 254)
+
+// Select the DMAC CRC engine when it passes a self-test, else keep using the
+// software implementation. Call after the DMA controller has been
+// initialized, e.g. after `Adafruit_NeoPixel_ZeroDMA::begin()`. Returns true
+// when the hardware is used.
+bool dvgCrc16Begin();
+
+// True when `dvgCrc16()` uses the DMAC CRC engine
+bool dvgCrc16Hardware();
+
+uint16_t dvgCrc16(const uint8_t *data, uint16_t len);
+
+// Software implementation, also used on the host
+uint16_t dvgCrc16Soft(const uint8_t *data, uint16_t len, uint16_t crc = 0xFFFF);
+
+// Encode `payload` into a complete frame, delimiters included. `out` must
+// hold `DVG_FRAME_ENCODED(len)` bytes. Returns the number of bytes written.
+uint16_t dvgFrameEncode(const uint8_t *payload, uint16_t len, uint8_t *out);
+
+// Decode the bytes received between the delimiters, in place. Returns the
+// payload length, or -1 on a COBS or CRC error.
+int16_t dvgFrameDecode(uint8_t *buf, uint16_t len);
+
+#endif
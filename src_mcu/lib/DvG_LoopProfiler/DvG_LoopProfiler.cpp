@@ -0,0 +1,102 @@
+#include "DvG_LoopProfiler.h"
+
+volatile uint32_t DvG_LoopProfiler::_sysTickCycles = 0;
+
+#ifdef DVG_PROFILE_LOOP
+// Called by the SysTick interrupt of the SAMD core once per period. Returning
+// 0 lets the core go on with its own handling, i.e. `millis()`.
+extern "C" int sysTickHook(void) {
+  DvG_LoopProfiler::_sysTickCycles += SysTick->LOAD + 1;
+  return 0;
+}
+#endif
+
+DvG_LoopProfiler::DvG_LoopProfiler(const char* const* names,
+                                   uint8_t n_sections) {
+  _names = names;
+  _n_sections = min(n_sections, (uint8_t) PROF_N_SECTIONS);
+  reset();
+}
+
+void DvG_LoopProfiler::reset() {
+  memset(_sec, 0, sizeof(_sec));
+  for (uint8_t i = 0; i < PROF_N_SECTIONS; i++) {
+    _sec[i].min = 0xFFFFFFFF;
+    _f_period[i] = false;
+  }
+}
+
+void DvG_LoopProfiler::record(uint8_t section, uint32_t cycles) {
+  if (section >= _n_sections) {
+    return;
+  }
+
+  // Bin = number of significant bits
+  static const uint8_t nibble_bits[16] = {0, 1, 2, 2, 3, 3, 3, 3,
+                                          4, 4, 4, 4, 4, 4, 4, 4};
+  uint32_t x = cycles;
+  uint8_t bin = 0;
+  if (x >> 16) {
+    x >>= 16;
+    bin = 16;
+  }
+  if (x >> 8) {
+    x >>= 8;
+    bin += 8;
+  }
+  if (x >> 4) {
+    x >>= 4;
+    bin += 4;
+  }
+  bin += nibble_bits[x];
+
+  Section& s = _sec[section];
+  s.bins[bin < PROF_N_BINS ? bin : PROF_N_BINS - 1]++;
+  s.count++;
+  s.sum += cycles;
+  if (cycles < s.min) s.min = cycles;
+  if (cycles > s.max) s.max = cycles;
+}
+
+void DvG_LoopProfiler::period(uint8_t section) {
+  if (section >= _n_sections) {
+    return;
+  }
+
+  uint32_t t = now();
+  if (_f_period[section]) {
+    record(section, t - _t_period[section]);
+  }
+  _t_period[section] = t;
+  _f_period[section] = true;
+}
+
+void DvG_LoopProfiler::print(Print& out) {
+  // Per section one summary line followed by one line per non-empty bin:
+  //   prof <name> n <count> min <min> avg <avg> max <max>
+  //   prof <name> < <upper bin edge> <count>
+  for (uint8_t i = 0; i < _n_sections; i++) {
+    Section& s = _sec[i];
+    out.print("prof ");
+    out.print(_names[i]);
+    out.print(" n ");
+    out.print(s.count);
+    out.print(" min ");
+    out.print(s.count ? s.min : 0);
+    out.print(" avg ");
+    out.print(s.count ? (uint32_t)(s.sum / s.count) : 0);
+    out.print(" max ");
+    out.println(s.max);
+
+    for (uint8_t bin = 0; bin < PROF_N_BINS; bin++) {
+      if (s.bins[bin]) {
+        out.print("prof ");
+        out.print(_names[i]);
+        out.print(bin < PROF_N_BINS - 1 ? " < " : " >= ");
+        out.print(bin < PROF_N_BINS - 1 ? (1UL << bin) : (1UL << (bin - 1)));
+        out.print(" ");
+        out.println(s.bins[bin]);
+      }
+    }
+  }
+}
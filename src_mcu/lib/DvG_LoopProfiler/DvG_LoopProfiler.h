@@ -0,0 +1,102 @@
+/*
+Lightweight per-section profiler for the main loop. Keeps the count, sum,
+minimum and maximum of the number of CPU cycles spent in each marked section
+of code, plus a histogram with power-of-two bins over all its durations, so
+that even rare long ones show up. The Cortex-M0+ has no CLZ instruction, so
+the bin is found with three compares and a 16-entry lookup table. Recording
+a duration is thus only a few adds, compares and stores. Timestamps are taken from the SysTick counter that also
+drives `millis()` and `micros()`, extended by a wrap counter of the profiler
+itself, so no extra hardware timer is needed. The Cortex-M0+ of the SAMD21
+lacks the DWT cycle counter of larger cores.
+
+The markers are macros that compile to nothing unless `DVG_PROFILE_LOOP` is
+defined before including this header, e.g. as a build flag in
+`platformio.ini`:
+
+  build_flags = -D DVG_PROFILE_LOOP
+
+Usage:
+  DvG_LoopProfiler prof;                  // Global
+
+  void loop() {
+    PROF_PERIOD(prof, 0);                 // Whole-loop period in section 0
+    PROF_START(t_serial);
+    ... code ...
+    PROF_STOP(prof, 1, t_serial);         // Time spent since PROF_START
+  }
+*/
+
+#ifndef DvG_LoopProfiler_h
+#define DvG_LoopProfiler_h
+
+#include <Arduino.h>
+
+// Maximum number of sections
+#define PROF_N_SECTIONS 6
+
+// Number of histogram bins. Bin `i` counts durations in the range
+// [2^(i-1), 2^i) cycles, bin 0 counts 0 cycles. 27 bins cover up to ~1.4 s
+// at 48 MHz, the last bin collects everything longer.
+#define PROF_N_BINS 27
+
+#ifdef DVG_PROFILE_LOOP
+#  define PROF_START(t) uint32_t t = DvG_LoopProfiler::now()
+#  define PROF_STOP(prof, section, t)                                          \
+    prof.record(section, DvG_LoopProfiler::now() - t)
+#  define PROF_PERIOD(prof, section) prof.period(section)
+#else
+#  define PROF_START(t)
+#  define PROF_STOP(prof, section, t)
+#  define PROF_PERIOD(prof, section)
+#endif
+
+class DvG_LoopProfiler {
+ public:
+  // `names` is an array of `n_sections` section names used by `print()`
+  DvG_LoopProfiler(const char* const* names, uint8_t n_sections);
+
+  // Free-running 32-bit CPU cycle counter, wraps around every ~89 s at
+  // 48 MHz. Take differences as unsigned numbers. Only reads again when the
+  // SysTick interrupt advanced the wrap counter in between.
+  static inline uint32_t now() {
+    uint32_t base, val;
+    do {
+      base = _sysTickCycles;
+      val = SysTick->VAL;
+    } while (base != _sysTickCycles);
+    return base + (SysTick->LOAD - val);
+  }
+
+  // Cycles of all completed SysTick periods, advanced by the SysTick
+  // interrupt, see `sysTickHook()` in DvG_LoopProfiler.cpp
+  static volatile uint32_t _sysTickCycles;
+
+  // Add a duration in cycles to the statistics of `section`
+  void record(uint8_t section, uint32_t cycles);
+
+  // Add the duration since the previous call to the histogram of `section`
+  void period(uint8_t section);
+
+  // Print the statistics of all sections and their non-empty histogram bins,
+  // both since the previous `reset()`
+  void print(Print& out);
+
+  void reset();
+
+ private:
+  struct Section {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;  // 32 bits would wrap after ~89 s at 48 MHz
+    uint32_t bins[PROF_N_BINS];
+  };
+
+  const char* const* _names;
+  uint8_t _n_sections;
+  Section _sec[PROF_N_SECTIONS];
+  uint32_t _t_period[PROF_N_SECTIONS];  // Previous timestamp for `period()`
+  bool _f_period[PROF_N_SECTIONS];      // `_t_period` is valid?
+};
+
+#endif
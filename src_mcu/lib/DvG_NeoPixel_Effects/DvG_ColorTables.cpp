@@ -0,0 +1,10 @@
+#include "DvG_ColorTables.h"
+
+static_assert(dvgWheel(0) == 0xFF0000, "Wheel must start at red");
+static_assert(dvgWheel(85) == 0x00FF00, "Wheel must pass green");
+static_assert(dvgWheel(170) == 0x0000FF, "Wheel must pass blue");
+static_assert(dvgHue(0) == 0xFF0000, "Hue must start at red");
+
+// `const` places the tables in flash
+const uint32_t dvg_wheel_table[256] = {DVG_TABLE256(dvgWheel)};
+const uint32_t dvg_hue_table[256] = {DVG_TABLE256(dvgHue)};
@@ -0,0 +1,64 @@
+/*
+Compile-time generated colour tables for DvG_NeoPixel_Effects. Each table
+holds 256 packed 0x00RRGGBB colours and lives in flash, so rendering a pixel
+is a single table fetch instead of branches and multiplies.
+
+  dvg_wheel_table[i]  Same as the classic `Wheel(i)`: r - g - b - back to r
+  dvg_hue_table[i]    Same as `Adafruit_NeoPixel::ColorHSV(i * 256)` at full
+                      saturation and value
+
+The tables are linear: gamma correction is applied by
+`Adafruit_NeoPixel_ZeroDMA::show()`, together with the brightness.
+
+Arduino-free on purpose, so that the host benchmark can include it.
+*/
+
+#ifndef DvG_ColorTables_h
+#define DvG_ColorTables_h
+
+#include <stdint.h>
+
+constexpr uint32_t dvgRGB(uint32_t r, uint32_t g, uint32_t b) {
+  return (r << 16) | (g << 8) | b;
+}
+
+// `Wheel()`, with p = 255 - WheelPos
+constexpr uint32_t dvgWheelRev(uint32_t p) {
+  return p < 85    ? dvgRGB(255 - p * 3, 0, p * 3)
+         : p < 170 ? dvgRGB(0, (p - 85) * 3, 255 - (p - 85) * 3)
+                   : dvgRGB((p - 170) * 3, 255 - (p - 170) * 3, 0);
+}
+
+constexpr uint32_t dvgWheel(uint32_t pos) { return dvgWheelRev(255 - pos); }
+
+// `ColorHSV()` at full saturation and value, with h the hue in 0 to 1530
+constexpr uint32_t dvgHue1530(uint32_t h) {
+  return h < 255    ? dvgRGB(255, h, 0)
+         : h < 510  ? dvgRGB(510 - h, 255, 0)
+         : h < 765  ? dvgRGB(0, 255, h - 510)
+         : h < 1020 ? dvgRGB(0, 1020 - h, 255)
+         : h < 1275 ? dvgRGB(h - 1020, 0, 255)
+         : h < 1530 ? dvgRGB(255, 0, 1530 - h)
+                    : dvgRGB(255, 0, 0);
+}
+
+constexpr uint32_t dvgHue(uint32_t i) {
+  return dvgHue1530((i * 256 * 1530 + 32768) / 65536);
+}
+
+// Expand `f(0), f(1), ..., f(255)` as an array initializer
+#define DVG_TABLE4(f, i) f(i), f(i + 1), f(i + 2), f(i + 3)
+#define DVG_TABLE16(f, i)                                                      \
+  DVG_TABLE4(f, i), DVG_TABLE4(f, i + 4), DVG_TABLE4(f, i + 8),                \
+      DVG_TABLE4(f, i + 12)
+#define DVG_TABLE64(f, i)                                                      \
+  DVG_TABLE16(f, i), DVG_TABLE16(f, i + 16), DVG_TABLE16(f, i + 32),           \
+      DVG_TABLE16(f, i + 48)
+#define DVG_TABLE256(f)                                                        \
+  DVG_TABLE64(f, 0), DVG_TABLE64(f, 64), DVG_TABLE64(f, 128),                  \
+      DVG_TABLE64(f, 192)
+
+extern const uint32_t dvg_wheel_table[256];
+extern const uint32_t dvg_hue_table[256];
+
+#endif
@@ -0,0 +1,220 @@
+#include "DvG_EffectTimeline.h"
+
+#ifdef Use_Adafruit_NeoPixel_ZeroDMA
+DvG_EffectTimeline::DvG_EffectTimeline(Adafruit_NeoPixel_ZeroDMA *thisStrip,
+                                       uint16_t frame_ms) {
+#else
+DvG_EffectTimeline::DvG_EffectTimeline(Adafruit_NeoPixel *thisStrip,
+                                       uint16_t frame_ms) {
+#endif
+  strip = thisStrip;
+  this->frame_ms = frame_ms;
+  steps = NULL;
+  n_steps = 0;
+  step_idx = 0;
+  loop = true;
+  done = true;
+  step_start = 0;
+  last_frame = 0;
+  ov_color_from = 0;
+  ov_color_to = 0;
+  ov_alpha_from = 0;
+  ov_alpha_to = 0;
+  ov_start = 0;
+  ov_fade = 0;
+}
+
+void DvG_EffectTimeline::setSequence(const DvG_TimelineStep *steps,
+                                     uint8_t n_steps, bool loop) {
+  this->steps = steps;
+  this->n_steps = n_steps;
+  this->loop = loop;
+  step_idx = 0;
+  done = (n_steps == 0);
+  step_start = millis();
+  last_frame = step_start - frame_ms; // Render at the next update()
+}
+
+/*******************************************************************************
+   OVERRIDE LAYER
+*******************************************************************************/
+
+uint16_t DvG_EffectTimeline::overrideRamp(uint32_t now) {
+  // 0 to 256 over `ov_fade` ms
+  uint32_t t = now - ov_start;
+  return (t >= ov_fade) ? 256 : (uint16_t)((t << 8) / ov_fade);
+}
+
+void DvG_EffectTimeline::setOverride(uint32_t color, uint16_t fade) {
+  uint32_t now = millis();
+  uint16_t ramp = overrideRamp(now);
+  uint16_t alpha =
+      ov_alpha_from + (((int32_t)ov_alpha_to - ov_alpha_from) * ramp >> 8);
+
+  // Start from the color as currently seen, or directly from `color` when
+  // the layer is invisible so that no stale color tints the fade-in
+  ov_color_from =
+      (alpha == 0) ? color : blend(ov_color_from, ov_color_to, ramp);
+  ov_color_to = color;
+  ov_alpha_from = alpha;
+  ov_alpha_to = 256;
+  ov_start = now;
+  ov_fade = fade;
+}
+
+void DvG_EffectTimeline::clearOverride(uint16_t fade) {
+  uint32_t now = millis();
+  uint16_t ramp = overrideRamp(now);
+
+  ov_color_from = ov_color_to = blend(ov_color_from, ov_color_to, ramp);
+  ov_alpha_from =
+      ov_alpha_from + (((int32_t)ov_alpha_to - ov_alpha_from) * ramp >> 8);
+  ov_alpha_to = 0;
+  ov_start = now;
+  ov_fade = fade;
+}
+
+/*******************************************************************************
+   RENDERING
+*******************************************************************************/
+
+uint32_t DvG_EffectTimeline::blend(uint32_t a, uint32_t b, uint16_t alpha) {
+  // Two channels per multiply: the weights add up to 256, so each 8-bit
+  // channel times its weight fits its own 16-bit lane
+  uint16_t beta = 256 - alpha;
+  uint32_t rb =
+      (((a & 0x00FF00FF) * beta + (b & 0x00FF00FF) * alpha) >> 8) & 0x00FF00FF;
+  uint32_t wg =
+      (((a >> 8) & 0x00FF00FF) * beta + ((b >> 8) & 0x00FF00FF) * alpha) &
+      0xFF00FF00;
+  return rb | wg;
+}
+
+uint32_t DvG_EffectTimeline::stepFade(const DvG_TimelineStep &s) {
+  return (s.fade < s.duration) ? s.fade : s.duration;
+}
+
+uint32_t DvG_EffectTimeline::stepLead(const DvG_TimelineStep &s) {
+  // A crossfade lasting the whole step leaves no lead, the next step then
+  // starts once the crossfade is over, or the timeline would never advance
+  uint32_t fade = stepFade(s);
+  return (fade < s.duration) ? s.duration - fade : s.duration;
+}
+
+void DvG_EffectTimeline::prepare(Cursor &c, const DvG_TimelineStep &s,
+                                 uint32_t t) {
+  uint32_t ticks = t / (s.wait ? s.wait : 1);
+
+  c.kind = s.kind;
+  c.color = s.color;
+  c.pos = 0;
+  c.step = 0;
+  c.wiped = 0;
+  switch (s.kind) {
+  case EFFECT_COLOR_WIPE:
+    c.wiped = (ticks < strip->numPixels()) ? ticks + 1 : strip->numPixels();
+    break;
+  case EFFECT_RAINBOW_SPATIAL:
+    c.step = 65536 / strip->numPixels();
+    c.pos = ticks << 8;
+    break;
+  case EFFECT_RAINBOW_TEMPORAL:
+    c.pos = ticks << 8;
+    break;
+  default:
+    break;
+  }
+}
+
+uint32_t DvG_EffectTimeline::pixelColor(Cursor &c, uint16_t iPx) {
+  uint32_t color;
+
+  switch (c.kind) {
+  case EFFECT_COLOR_WIPE:
+    return (iPx < c.wiped) ? c.color : 0;
+  case EFFECT_RAINBOW_SPATIAL:
+    color = dvg_wheel_table[(c.pos >> 8) & 255];
+    c.pos += c.step;
+    return color;
+  case EFFECT_RAINBOW_TEMPORAL:
+    return dvg_wheel_table[(c.pos >> 8) & 255];
+  case EFFECT_FULL_COLOR:
+  default:
+    return c.color;
+  }
+}
+
+bool DvG_EffectTimeline::update(void) {
+  uint32_t now = millis();
+  if (done && (ov_alpha_from == 0) && (ov_alpha_to == 0)) {
+    return false;
+  }
+  if (now - last_frame < frame_ms) {
+    return false;
+  }
+  last_frame = now;
+  uint32_t t_start = micros();
+
+  // Advance at most one step per frame. The next step starts at the
+  // beginning of the crossfade into it, keeping the sequence phase-locked.
+  Cursor cur, next;
+  uint16_t alpha = 0; // Crossfade from `cur` to `next`
+  bool has_next = false;
+  bool has_cur = (n_steps > 0);
+
+  if (has_cur) {
+    const DvG_TimelineStep *s = &steps[step_idx];
+    uint32_t t = now - step_start;
+    bool is_last = (step_idx + 1 >= n_steps);
+
+    if (!done && (t >= s->duration)) {
+      if (is_last && !loop) {
+        done = true;
+      } else {
+        step_start += stepLead(*s);
+        step_idx = is_last ? 0 : step_idx + 1;
+        s = &steps[step_idx];
+        t = now - step_start;
+        is_last = (step_idx + 1 >= n_steps);
+      }
+    }
+    if (done) {
+      t = s->duration; // Hold the final frame
+    }
+    prepare(cur, *s, t);
+
+    uint32_t fade = stepFade(*s);
+    uint32_t t_fade = s->duration - fade;
+    if (!done && fade && (t >= t_fade) && !(is_last && !loop)) {
+      has_next = true;
+      alpha = ((t - t_fade) >= fade) ? 256
+                                     : (uint16_t)(((t - t_fade) << 8) / fade);
+      prepare(next, steps[is_last ? 0 : step_idx + 1], t - t_fade);
+    }
+  }
+
+  // Override layer
+  uint16_t ramp = overrideRamp(now);
+  uint32_t ov_color = blend(ov_color_from, ov_color_to, ramp);
+  uint16_t ov_alpha =
+      ov_alpha_from + (((int32_t)ov_alpha_to - ov_alpha_from) * ramp >> 8);
+  if (ramp == 256) {
+    ov_color_from = ov_color_to;
+    ov_alpha_from = ov_alpha_to;
+  }
+
+  for (uint16_t iPx = 0; iPx < strip->numPixels(); iPx++) {
+    uint32_t color = has_cur ? pixelColor(cur, iPx) : 0;
+    if (has_next) {
+      color = blend(color, pixelColor(next, iPx), alpha);
+    }
+    if (ov_alpha) {
+      color = blend(color, ov_color, ov_alpha);
+    }
+    strip->setPixelColor(iPx, color);
+  }
+  strip->show();
+  stats.record(t_start, micros(), frame_ms);
+
+  return true;
+}
@@ -0,0 +1,123 @@
+/*
+Effect timeline engine for NeoPixel strips. Plays a sequence of effects,
+each with its own duration, and blends each effect into the next one with a
+fixed-point alpha crossfade. On top of the sequence sits a solid-colour
+override layer that fades in and out as well, e.g. for an 'only white' mode.
+
+The timeline is stateless per pixel: every frame the colour of each pixel is
+computed from the time elapsed within the current step, so a frame always
+costs the same bounded amount of work: at most two effects and two blends per
+pixel, plus a handful of divisions per frame. Nothing is allocated on the
+heap; the sequence is a caller-owned array that may live in flash.
+
+Usage:
+  const DvG_TimelineStep seq[] = {
+    // kind,                   color,   wait, duration, fade
+    {EFFECT_RAINBOW_TEMPORAL,  0,       50,   12800,    1000},
+    {EFFECT_FULL_COLOR,        0xFF0000, 0,   2000,     500},
+  };
+  DvG_EffectTimeline timeline(&strip);
+  timeline.setSequence(seq, 2);
+
+  void loop() { timeline.update(); }
+*/
+
+#ifndef DvG_EffectTimeline_h
+#define DvG_EffectTimeline_h
+
+#include "DvG_NeoPixel_Effects.h"
+#include "DvG_FrameStats.h"
+
+enum DvG_EffectKind : uint8_t {
+  EFFECT_FULL_COLOR,       // All pixels `color`
+  EFFECT_COLOR_WIPE,       // Pixels turn `color` one by one, every `wait` ms
+  EFFECT_RAINBOW_SPATIAL,  // Wheel spread over the strip, shifts every `wait`
+  EFFECT_RAINBOW_TEMPORAL  // All pixels cycle the wheel, shifts every `wait`
+};
+
+struct DvG_TimelineStep {
+  DvG_EffectKind kind;
+  uint32_t color;    // Packed WRGB color, see `Color()`
+  uint16_t wait;     // [ms] Effect speed, see `DvG_EffectKind`
+  uint32_t duration; // [ms] Including the crossfade into the next step
+  uint16_t fade;     // [ms] Crossfade into the next step. At or above
+                     // `duration` it lasts the whole step.
+};
+
+class DvG_EffectTimeline {
+public:
+#ifdef Use_Adafruit_NeoPixel_ZeroDMA
+  DvG_EffectTimeline(Adafruit_NeoPixel_ZeroDMA *thisStrip,
+                     uint16_t frame_ms = 20);
+#else
+  DvG_EffectTimeline(Adafruit_NeoPixel *thisStrip, uint16_t frame_ms = 20);
+#endif
+
+  // Start playing `steps` from the first step. When `loop` is false, the
+  // last step holds its final frame once done.
+  void setSequence(const DvG_TimelineStep *steps, uint8_t n_steps,
+                   bool loop = true);
+
+  // Fade the override layer in to `color`, or from its current color over
+  // to `color` when already visible, in `fade` ms
+  void setOverride(uint32_t color, uint16_t fade);
+  // Fade the override layer out in `fade` ms
+  void clearOverride(uint16_t fade);
+
+  // Render and show a frame when one is due. Returns true when rendered.
+  bool update(void);
+
+  // Frames rendered by update()
+  DvG_FrameStats &frameStats(void) { return stats; }
+
+  bool isDone(void) { return done; }
+  uint8_t currentStep(void) { return step_idx; }
+
+  // Blend two packed colors, alpha 0 (all `a`) to 256 (all `b`)
+  static uint32_t blend(uint32_t a, uint32_t b, uint16_t alpha);
+
+private:
+#ifdef Use_Adafruit_NeoPixel_ZeroDMA
+  Adafruit_NeoPixel_ZeroDMA *strip;
+#else
+  Adafruit_NeoPixel *strip;
+#endif
+
+  // Per-frame state of one effect, so that rendering a pixel needs no
+  // division
+  struct Cursor {
+    DvG_EffectKind kind;
+    uint32_t color;
+    uint32_t pos;   // Wheel position in 8.8 fixed point
+    uint32_t step;  // Wheel position increment per pixel, 8.8 fixed point
+    uint16_t wiped; // Number of pixels wiped
+  };
+  void prepare(Cursor &c, const DvG_TimelineStep &s, uint32_t t);
+  uint32_t pixelColor(Cursor &c, uint16_t iPx);
+  uint16_t overrideRamp(uint32_t now);
+
+  // Crossfade of step `s` [ms], at most its duration
+  static uint32_t stepFade(const DvG_TimelineStep &s);
+  // Time [ms] from the start of step `s` to the start of the next step
+  static uint32_t stepLead(const DvG_TimelineStep &s);
+
+  const DvG_TimelineStep *steps;
+  uint8_t n_steps;
+  uint8_t step_idx;
+  bool loop;
+  bool done;
+  uint32_t step_start; // [ms] millis() at the start of the current step
+  uint16_t frame_ms;
+  uint32_t last_frame; // [ms] Compare as `now - last_frame`, wrap-safe
+  DvG_FrameStats stats;
+
+  // Override layer, ramps from the 'from' to the 'to' color and alpha
+  uint32_t ov_color_from;
+  uint32_t ov_color_to;
+  uint16_t ov_alpha_from;
+  uint16_t ov_alpha_to;
+  uint32_t ov_start; // [ms]
+  uint16_t ov_fade;  // [ms]
+};
+
+#endif
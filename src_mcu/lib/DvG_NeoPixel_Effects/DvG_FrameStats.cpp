@@ -0,0 +1,52 @@
+#include "DvG_FrameStats.h"
+
+void DvG_FrameStats::reset(void) {
+  frames = 0;
+  wait = 0;
+  f_last = false;
+  n_interval = 0;
+  interval_sum = 0;
+  interval_min = 0xFFFFFFFF;
+  interval_max = 0;
+  render_sum = 0;
+  render_max = 0;
+}
+
+void DvG_FrameStats::record(uint32_t t_start, uint32_t t_end, uint32_t wait) {
+  uint32_t dt;
+
+  frames++;
+  this->wait = wait;
+  if (f_last) {
+    dt = t_start - t_last;
+    n_interval++;
+    interval_sum += dt;
+    if (dt < interval_min) interval_min = dt;
+    if (dt > interval_max) interval_max = dt;
+  }
+  f_last = true;
+  t_last = t_start;
+
+  dt = t_end - t_start;
+  render_sum += dt;
+  if (dt > render_max) render_max = dt;
+}
+
+void DvG_FrameStats::print(Print &out, const char *name) {
+  out.print("leds ");
+  out.print(name);
+  out.print(" frames ");
+  out.print(frames);
+  out.print(" wait ");
+  out.print(wait * 1000);
+  out.print(" interval ");
+  out.print(n_interval ? interval_sum / n_interval : 0);
+  out.print(" ");
+  out.print(n_interval ? interval_min : 0);
+  out.print(" ");
+  out.print(interval_max);
+  out.print(" render ");
+  out.print(frames ? render_sum / frames : 0);
+  out.print(" ");
+  out.println(render_max);
+}
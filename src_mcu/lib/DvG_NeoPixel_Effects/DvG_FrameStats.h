@@ -0,0 +1,37 @@
+/*
+Frame statistics of an LED effect: the number of frames rendered, the
+achieved frame interval compared with the requested one, and the time spent
+rendering a frame, `show()` included. Times are in [us] from `micros()`.
+*/
+
+#ifndef DvG_FrameStats_h
+#define DvG_FrameStats_h
+
+#include <Arduino.h>
+
+class DvG_FrameStats {
+public:
+  DvG_FrameStats() { reset(); }
+
+  void reset(void);
+
+  // Record a frame rendered from `t_start` to `t_end` [us], requested to
+  // follow the previous frame after `wait` [ms]
+  void record(uint32_t t_start, uint32_t t_end, uint32_t wait);
+
+  // One line:
+  //   leds <name> frames <n> wait <us> interval <avg> <min> <max> render
+  //   <avg> <max>
+  void print(Print &out, const char *name);
+
+private:
+  uint32_t frames;
+  uint32_t wait;     // [ms] Requested interval of the latest frame
+  bool f_last;       // `t_last` is valid
+  uint32_t t_last;   // [us] Start of the previous frame
+  uint32_t n_interval;
+  uint32_t interval_sum, interval_min, interval_max; // [us]
+  uint32_t render_sum, render_max;                   // [us]
+};
+
+#endif
@@ -18,16 +18,12 @@ bool DvG_NeoPixel_Effects::effectIsDone(void) { return effect_is_done; }
 uint32_t DvG_NeoPixel_Effects::Wheel(byte WheelPos) {
   // Input a value 0 to 255 to get a color value.
   // The colours are a transition r - g - b - back to r.
-  WheelPos = 255 - WheelPos;
-  if (WheelPos < 85) {
-    return strip->Color(255 - WheelPos * 3, 0, WheelPos * 3, 0);
-  }
-  if (WheelPos < 170) {
-    WheelPos -= 85;
-    return strip->Color(0, WheelPos * 3, 255 - WheelPos * 3, 0);
-  }
-  WheelPos -= 170;
-  return strip->Color(WheelPos * 3, 255 - WheelPos * 3, 0, 0);
+  return dvg_wheel_table[WheelPos];
+}
+
+uint32_t DvG_NeoPixel_Effects::Hue(byte HuePos) {
+  // Input a value 0 to 255 to get a fully saturated color value of that hue
+  return dvg_hue_table[HuePos];
 }
 
 uint8_t DvG_NeoPixel_Effects::red(uint32_t c) { return (c >> 16); }
@@ -56,7 +52,7 @@ void DvG_NeoPixel_Effects::holdAndWait(uint32_t wait) {
   if (effect_is_done) {
     startup();
   }
-  if (now > last_update + wait) {
+  if (now - last_update > wait) {
     finish();
   }
 }
@@ -71,7 +67,7 @@ void DvG_NeoPixel_Effects::fullColor(uint32_t c, uint16_t wait) {
     strip->show();
   }
 
-  if (now > last_update + wait) {
+  if (now - last_update > wait) {
     finish();
   }
 }
@@ -79,7 +75,7 @@ void DvG_NeoPixel_Effects::fullColor(uint32_t c, uint16_t wait) {
 void DvG_NeoPixel_Effects::colorWipe(uint32_t c, uint16_t wait) {
   // Fill the dots one after the other with a color
   now = millis();
-  if (effect_is_done | (now > last_update + wait)) {
+  if (effect_is_done | (now - last_update > wait)) {
     startup();
     strip->setPixelColor(iPx, c);
     strip->show();
@@ -93,11 +89,13 @@ void DvG_NeoPixel_Effects::colorWipe(uint32_t c, uint16_t wait) {
 
 void DvG_NeoPixel_Effects::rainbowSpatial(uint16_t wait, uint8_t num_cycles) {
   now = millis();
-  if (effect_is_done | (now > last_update + wait)) {
+  if (effect_is_done | (now - last_update > wait)) {
     startup();
-    for (iPx = 0; iPx < strip->numPixels(); iPx++) {
-      strip->setPixelColor(iPx,
-                           Wheel(((iPx * 256 / strip->numPixels()) + j) & 255));
+    // Wheel position per pixel in 8.8 fixed point: one division per frame
+    uint32_t step = 65536 / strip->numPixels();
+    uint32_t pos = j << 8;
+    for (iPx = 0; iPx < strip->numPixels(); iPx++, pos += step) {
+      strip->setPixelColor(iPx, dvg_wheel_table[(pos >> 8) & 255]);
     }
     strip->show();
 
@@ -110,10 +108,10 @@ void DvG_NeoPixel_Effects::rainbowSpatial(uint16_t wait, uint8_t num_cycles) {
 
 void DvG_NeoPixel_Effects::rainbowTemporal(uint16_t wait) {
   now = millis();
-  if (effect_is_done | (now > last_update + wait)) {
+  if (effect_is_done | (now - last_update > wait)) {
     startup();
     for (iPx = 0; iPx < strip->numPixels(); iPx++) {
-      strip->setPixelColor(iPx, Wheel(j & 255));
+      strip->setPixelColor(iPx, dvg_wheel_table[j & 255]);
     }
     strip->show();
 
@@ -0,0 +1,84 @@
+#include "DvG_Scheduler.h"
+
+DvG_Scheduler::DvG_Scheduler(DvG_Stepper& stepper, DvG_TaskFunc stepper_task)
+    : _stepper(stepper) {
+  _stepper_task = stepper_task;
+  _n_tasks = 0;
+}
+
+bool DvG_Scheduler::addTask(const char* name, DvG_TaskFunc func,
+                            uint32_t budget_us, uint32_t max_defer_us) {
+  if (_n_tasks >= SCHED_N_TASKS) {
+    return false;
+  }
+
+  Task& task = _tasks[_n_tasks];
+  task.name = name;
+  task.func = func;
+  task.budget_us = budget_us;
+  task.max_defer_us = max_defer_us;
+  task.t_last_run = micros();
+  _n_tasks++;
+  resetStats();
+  return true;
+}
+
+void DvG_Scheduler::run() {
+  uint32_t t_start;
+  uint32_t duration;
+  bool fForced;
+
+  _stepper_task();
+
+  for (uint8_t i = 0; i < _n_tasks; i++) {
+    Task& task = _tasks[i];
+
+    t_start = micros();
+    fForced = (t_start - task.t_last_run >= task.max_defer_us);
+    if (!fForced && (_stepper.timeUntilNextStep() < task.budget_us)) {
+      task.skips++;
+      continue;
+    }
+
+    task.func();
+    duration = micros() - t_start;
+
+    task.t_last_run = t_start;
+    task.runs++;
+    if (fForced) task.forced++;
+    if (duration > task.budget_us) task.overruns++;
+    if (duration > task.max_us) task.max_us = duration;
+
+    // Catch up on a step that might have become due meanwhile
+    _stepper_task();
+  }
+}
+
+void DvG_Scheduler::print(Print& out) {
+  for (uint8_t i = 0; i < _n_tasks; i++) {
+    Task& task = _tasks[i];
+    out.print("sched ");
+    out.print(task.name);
+    out.print(" runs ");
+    out.print(task.runs);
+    out.print(" skips ");
+    out.print(task.skips);
+    out.print(" forced ");
+    out.print(task.forced);
+    out.print(" overruns ");
+    out.print(task.overruns);
+    out.print(" max ");
+    out.println(task.max_us);
+  }
+}
+
+void DvG_Scheduler::resetStats() {
+  for (uint8_t i = 0; i < _n_tasks; i++) {
+    Task& task = _tasks[i];
+    task.runs = 0;
+    task.skips = 0;
+    task.forced = 0;
+    task.overruns = 0;
+    task.max_us = 0;
+  }
+}
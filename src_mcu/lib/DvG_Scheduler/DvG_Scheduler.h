@@ -0,0 +1,72 @@
+/*
+Cooperative, deadline-aware task scheduler for the main loop. Stepping is the
+hard real-time job of the firmware: every other piece of work delays the next
+step when it runs too close to the step deadline. Hence:
+
+  * The stepper task runs first on every pass, and again after every other
+    task, so a step is taken as soon as it is due.
+  * Each other task has a time budget and only runs when the slack until the
+    next step deadline, see `DvG_Stepper::timeUntilNextStep()`, is at least
+    that budget.
+  * A task that has been skipped for longer than its maximum deferral time is
+    forced to run anyway, so serial commands and LED effects never starve.
+  * A task taking longer than its budget is counted as an overrun.
+
+Usage:
+  DvG_Scheduler sched(Astepper, task_stepper);
+  sched.addTask("serial", task_serial, 300, 10000);
+
+  void loop() { sched.run(); }
+*/
+
+#ifndef DvG_Scheduler_h
+#define DvG_Scheduler_h
+
+#include <Arduino.h>
+
+#include "DvG_Stepper.h"
+
+// Maximum number of tasks besides the stepper task
+#define SCHED_N_TASKS 4
+
+typedef void (*DvG_TaskFunc)(void);
+
+class DvG_Scheduler {
+ public:
+  DvG_Scheduler(DvG_Stepper& stepper, DvG_TaskFunc stepper_task);
+
+  // Add a task with a time budget [us] and a maximum time [us] the task may
+  // be deferred for lack of slack. Returns false when the task table is full.
+  bool addTask(const char* name, DvG_TaskFunc func, uint32_t budget_us,
+               uint32_t max_defer_us);
+
+  // Perform one scheduling pass. Call this from `loop()`.
+  void run();
+
+  // Print the statistics of all tasks:
+  //   sched <name> runs <n> skips <n> forced <n> overruns <n> max <us>
+  void print(Print& out);
+
+  void resetStats();
+
+ private:
+  struct Task {
+    const char* name;
+    DvG_TaskFunc func;
+    uint32_t budget_us;
+    uint32_t max_defer_us;
+    uint32_t t_last_run;  // [us]
+    uint32_t runs;        // Number of times run
+    uint32_t skips;       // Number of times deferred for lack of slack
+    uint32_t forced;      // Number of runs forced by the maximum deferral
+    uint32_t overruns;    // Number of runs exceeding the budget
+    uint32_t max_us;      // Longest run
+  };
+
+  DvG_Stepper& _stepper;
+  DvG_TaskFunc _stepper_task;
+  Task _tasks[SCHED_N_TASKS];
+  uint8_t _n_tasks;
+};
+
+#endif
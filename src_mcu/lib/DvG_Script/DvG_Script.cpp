@@ -0,0 +1,192 @@
+#include "DvG_Script.h"
+
+#include <string.h>
+
+DvG_Script::DvG_Script(DvG_ScriptTarget& target) : _target(target) {
+  _len = 0;
+  _pc = 0;
+  _state = SCRIPT_IDLE;
+  _depth = 0;
+  _tWake = 0;
+  _fWaiting = false;
+  _fSweep = false;
+}
+
+bool DvG_Script::load(uint16_t offset, const uint8_t* data, uint16_t n) {
+  if (_state == SCRIPT_RUNNING) return false;
+  if (offset > _len || n > SCRIPT_LEN - offset) return false;
+  memcpy(&_code[offset], data, n);
+  if (offset + n > _len) _len = offset + n;
+  _state = SCRIPT_IDLE;
+  return true;
+}
+
+bool DvG_Script::clear() {
+  if (_state == SCRIPT_RUNNING) return false;
+  _len = 0;
+  _pc = 0;
+  _state = SCRIPT_IDLE;
+  return true;
+}
+
+uint16_t DvG_Script::u16(uint16_t pc) {
+  return (uint16_t)(_code[pc] | (_code[pc + 1] << 8));
+}
+
+uint32_t DvG_Script::u32(uint16_t pc) {
+  return ((uint32_t)_code[pc] | ((uint32_t)_code[pc + 1] << 8) |
+          ((uint32_t)_code[pc + 2] << 16) | ((uint32_t)_code[pc + 3] << 24));
+}
+
+uint8_t DvG_Script::opLength(uint16_t pc) {
+  switch (_code[pc]) {
+    case SCRIPT_END:
+    case SCRIPT_NEXT:
+      return 1;
+    case SCRIPT_STYLE:
+    case SCRIPT_RUN:
+      return 2;
+    case SCRIPT_LOOP:
+    case SCRIPT_LED_OFF:
+      return 3;
+    case SCRIPT_SPEED:
+    case SCRIPT_WAIT:
+      return 5;
+    case SCRIPT_LED:
+      return 7;
+    case SCRIPT_SWEEP:
+      return 9;
+    default:
+      return 0;
+  }
+}
+
+bool DvG_Script::start(uint32_t now) {
+  uint8_t depth = 0;
+  uint8_t n;
+
+  stop();
+
+  // Check every operation up front, so that a broken script never leaves the
+  // motor half way through a protocol
+  for (_pc = 0; _pc < _len; _pc += n) {
+    n = opLength(_pc);
+    if (n == 0 || n > _len - _pc) break;
+    if (_code[_pc] == SCRIPT_STYLE &&
+        (_code[_pc + 1] < 1 || _code[_pc + 1] > 4)) {
+      break;
+    }
+    if (_code[_pc] == SCRIPT_RUN && _code[_pc + 1] > 1) break;
+    if (_code[_pc] == SCRIPT_LOOP && ++depth > SCRIPT_LOOP_DEPTH) break;
+    if (_code[_pc] == SCRIPT_NEXT && depth-- == 0) break;
+  }
+  if (_pc < _len || depth != 0) {
+    _state = SCRIPT_INVALID;
+    return false;
+  }
+
+  _pc = 0;
+  _depth = 0;
+  _tWake = now;
+  _state = SCRIPT_RUNNING;
+  return true;
+}
+
+void DvG_Script::stop() {
+  if (_state == SCRIPT_RUNNING) _state = SCRIPT_IDLE;
+  _fWaiting = false;
+  _fSweep = false;
+}
+
+void DvG_Script::poll(uint32_t now, bool stepped) {
+  if (_state != SCRIPT_RUNNING) return;
+
+  if (_fWaiting) {
+    if ((int32_t)(now - _tWake) < 0) {
+      if (_fSweep && stepped) {
+        // Linear interpolation at this step
+        int64_t span = (int64_t)_sweepTo - _sweepFrom;
+        uint32_t dt = now - _tSweep;
+        _target.setSpeed(_sweepFrom + (int32_t)(span * dt / _sweepTime));
+      }
+      return;
+    }
+    if (_fSweep) _target.setSpeed(_sweepTo);
+    _fWaiting = false;
+    _fSweep = false;
+  }
+
+  for (uint8_t i = 0; i < SCRIPT_OPS_PER_POLL; i++) {
+    if (!step()) return;
+  }
+}
+
+bool DvG_Script::step() {
+  uint16_t pc = _pc;
+
+  if (pc >= _len) {
+    _state = SCRIPT_DONE;
+    return false;
+  }
+
+  _pc += opLength(pc);
+  switch (_code[pc]) {
+    case SCRIPT_END:
+      _pc = pc;
+      _state = SCRIPT_DONE;
+      return false;
+
+    case SCRIPT_SPEED:
+      _target.setSpeed((int32_t)u32(pc + 1));
+      break;
+
+    case SCRIPT_STYLE:
+      _target.setStyle(_code[pc + 1]);
+      break;
+
+    case SCRIPT_RUN:
+      _target.setRun(_code[pc + 1]);
+      break;
+
+    case SCRIPT_WAIT:
+      _tWake += u32(pc + 1);
+      _fWaiting = true;
+      return false;
+
+    case SCRIPT_SWEEP:
+      _sweepFrom = _target.speed();
+      _sweepTo = (int32_t)u32(pc + 1);
+      _sweepTime = u32(pc + 5);
+      _tSweep = _tWake;
+      _tWake += _sweepTime;
+      _fWaiting = true;
+      _fSweep = (_sweepTime > 0);
+      if (!_fSweep) _target.setSpeed(_sweepTo);
+      return false;
+
+    case SCRIPT_LOOP:
+      _loops[_depth].pc = _pc;
+      _loops[_depth].count = u16(pc + 1);
+      _depth++;
+      break;
+
+    case SCRIPT_NEXT: {
+      Loop& loop = _loops[_depth - 1];
+      if (loop.count == 0 || --loop.count > 0) {
+        _pc = loop.pc;
+      } else {
+        _depth--;
+      }
+      break;
+    }
+
+    case SCRIPT_LED:
+      _target.setLed(u32(pc + 1), u16(pc + 5));
+      break;
+
+    case SCRIPT_LED_OFF:
+      _target.clearLed(u16(pc + 1));
+      break;
+  }
+  return true;
+}
@@ -0,0 +1,153 @@
+/*
+Bytecode interpreter for experiment scripts, so that a protocol like "spin at
+1.33 rev/s for 60 s, then oscillate every 250 ms at 2.33 rev/s, then sweep to
+2.58 rev/s with the lights green" runs on the device with microsecond timing
+instead of being typed in by hand.
+
+A script is a sequence of operations, each an opcode byte followed by its
+little-endian operands:
+
+  SCRIPT_END                       Stop, also implied past the last byte
+  SCRIPT_SPEED    int32 speed      [urev per sec], see `setSpeedFixed()`
+  SCRIPT_STYLE    uint8 style      SINGLE, DOUBLE, INTERLEAVE or MICROSTEP
+  SCRIPT_RUN      uint8 on         0: release the motor, 1: run
+  SCRIPT_WAIT     uint32 time      [us]
+  SCRIPT_SWEEP    int32 speed,     Ramp linearly from the current speed to
+                  uint32 time      `speed` [urev per sec] in `time` [us]
+  SCRIPT_LOOP     uint16 count     Repeat up to the matching SCRIPT_NEXT
+                                   `count` times, 0: forever
+  SCRIPT_NEXT
+  SCRIPT_LED      uint32 color,    Fade the LED override in to `color`
+                  uint16 fade      in `fade` [ms]
+  SCRIPT_LED_OFF  uint16 fade      Fade the LED override out in `fade` [ms]
+
+Timing is on absolute deadlines: each WAIT or SWEEP ends a fixed time after
+the end of the previous one, counted from `start()`, and never from whenever
+the operation happened to get polled. Polling right after every step makes
+operations that are due take effect before the next step, so the motion does
+not depend on the poll latency as long as that stays below one step
+interval. A sweep updates the speed at every step.
+
+The interpreter only drives a `DvG_ScriptTarget` and is handed the time by
+the caller, so it is Arduino-free and the host tools can run the very same
+code against a simulated device.
+
+Usage:
+  DvG_Script script(target);
+  script.load(0, bytecode, len);
+  script.start(micros());
+
+  void task_stepper() {
+    bool stepped = Astepper.runSpeed();
+    script.poll(micros(), stepped);
+  }
+*/
+
+#ifndef DvG_Script_h
+#define DvG_Script_h
+
+#include <stdint.h>
+
+// Script buffer [bytes]
+#define SCRIPT_LEN 512
+
+// Maximum nesting of SCRIPT_LOOP
+#define SCRIPT_LOOP_DEPTH 4
+
+// Maximum number of operations executed per `poll()`, so that a loop without
+// any WAIT can not lock up the main loop
+#define SCRIPT_OPS_PER_POLL 8
+
+enum DvG_ScriptOp : uint8_t {
+  SCRIPT_END = 0x00,
+  SCRIPT_SPEED = 0x01,
+  SCRIPT_STYLE = 0x02,
+  SCRIPT_RUN = 0x03,
+  SCRIPT_WAIT = 0x04,
+  SCRIPT_SWEEP = 0x05,
+  SCRIPT_LOOP = 0x06,
+  SCRIPT_NEXT = 0x07,
+  SCRIPT_LED = 0x08,
+  SCRIPT_LED_OFF = 0x09
+};
+
+enum DvG_ScriptState : uint8_t {
+  SCRIPT_IDLE,     // Never started or stopped
+  SCRIPT_RUNNING,
+  SCRIPT_DONE,     // Reached its end
+  SCRIPT_INVALID   // Refused by `start()`, see `pc()`
+};
+
+// What a script acts upon
+class DvG_ScriptTarget {
+ public:
+  virtual void setSpeed(int32_t speed) = 0;  // [urev per sec]
+  virtual int32_t speed() = 0;               // [urev per sec]
+  virtual void setStyle(uint8_t style) = 0;
+  virtual void setRun(bool on) = 0;
+  virtual void setLed(uint32_t color, uint16_t fade) = 0;
+  virtual void clearLed(uint16_t fade) = 0;
+};
+
+class DvG_Script {
+ public:
+  DvG_Script(DvG_ScriptTarget& target);
+
+  // Copy `n` bytes of bytecode to `offset`, extending the script. Returns
+  // false while running or when the bytes do not fit.
+  bool load(uint16_t offset, const uint8_t* data, uint16_t n);
+
+  // Empty the script. Returns false while running.
+  bool clear();
+
+  // Check the script and run it from the top, `now` [us] being the time base
+  // of all deadlines. Returns false when the script is invalid, in which
+  // case `pc()` points at the offending operation.
+  bool start(uint32_t now);
+
+  void stop();
+
+  // Execute the operations that are due at `now` [us]. Call this after
+  // every step with `stepped` true, and regularly otherwise.
+  void poll(uint32_t now, bool stepped);
+
+  DvG_ScriptState state() { return _state; }
+  uint16_t pc() { return _pc; }
+  uint16_t length() { return _len; }
+
+  // Deadline [us] of the running WAIT or SWEEP
+  uint32_t wakeTime() { return _tWake; }
+
+ private:
+  struct Loop {
+    uint16_t pc;        // First operation of the body
+    uint16_t count;     // Iterations left, 0: forever
+  };
+
+  DvG_ScriptTarget& _target;
+  uint8_t _code[SCRIPT_LEN];
+  uint16_t _len;
+  uint16_t _pc;
+  DvG_ScriptState _state;
+  Loop _loops[SCRIPT_LOOP_DEPTH];
+  uint8_t _depth;
+  uint32_t _tWake;      // [us] Deadline of the running WAIT or SWEEP
+  bool _fWaiting;       // In a WAIT or SWEEP
+  bool _fSweep;         // In a SWEEP
+  uint32_t _tSweep;     // [us] Start of the sweep
+  uint32_t _sweepTime;  // [us] Duration of the sweep
+  int32_t _sweepFrom;   // [urev per sec]
+  int32_t _sweepTo;     // [urev per sec]
+
+  // Length of the operation at `pc` including its opcode, 0 when unknown
+  uint8_t opLength(uint16_t pc);
+
+  // Execute the operation at `_pc`. Returns false when the script waits or
+  // is done.
+  bool step();
+
+  uint16_t u16(uint16_t pc);
+  uint32_t u32(uint16_t pc);
+};
+
+#endif
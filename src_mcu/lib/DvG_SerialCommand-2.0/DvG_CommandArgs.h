@@ -0,0 +1,76 @@
+/*
+In-place tokenizer for the arguments of a command, e.g. "osc 2.33 250". One
+pass over the command string replaces the spaces in between the arguments by
+'\0' and records where each argument starts, so the arguments are handed out
+as C-strings pointing into the command buffer itself, without any copying:
+
+  void cmd_osc(char* strCmd) {
+    DvG_CommandArgs<2> args;
+    args.tokenize(strCmd, 3);              // Skip the name "osc"
+    int32_t speed = args.fixed(0, 6);      // 2330000
+    int32_t period = args.fixed(1, 0);     // 250
+  }
+
+At most N arguments are split off. Anything beyond stays attached to the
+last one, spaces included, so that e.g. a nested command can be passed on
+as a whole. Missing arguments read as empty strings, and parse as 0.
+
+Arduino-free on purpose, so that the host tools can include it.
+*/
+
+#ifndef DvG_CommandArgs_h
+#define DvG_CommandArgs_h
+
+#include <stdint.h>
+#include <string.h>
+
+#include "DvG_ParseFixed.h"
+
+template <uint8_t N>
+class DvG_CommandArgs {
+ public:
+  static_assert(N > 0, "Tokenizing needs room for at least one argument");
+
+  DvG_CommandArgs() { _n = 0; }
+
+  // Split `strCmd` in place into its arguments, starting at position `iPos`
+  // right behind the name of the command. Arguments are separated by one or
+  // more spaces. Returns the number of arguments.
+  uint8_t tokenize(char* strCmd, uint16_t iPos = 0) {
+    char* c = strCmd;
+
+    _n = 0;
+    for (; iPos > 0 && *c != '\0'; iPos--) c++;
+    while (true) {
+      while (*c == ' ') c++;
+      if (*c == '\0') break;
+      _argv[_n++] = c;
+      if (_n == N) break;
+      while (*c != ' ' && *c != '\0') c++;
+      if (*c == '\0') break;
+      *c++ = '\0';
+    }
+    return _n;
+  }
+
+  uint8_t count() { return _n; }
+
+  // Argument `i`, or an empty string when there is no such argument
+  const char* operator[](uint8_t i) { return (i < _n ? _argv[i] : ""); }
+
+  // True when argument `i` equals `word`
+  bool is(uint8_t i, const char* word) {
+    return strcmp((*this)[i], word) == 0;
+  }
+
+  // Argument `i` parsed into a fixed-point integer, see `dvgParseFixed()`
+  int32_t fixed(uint8_t i, uint8_t decimals) {
+    return dvgParseFixed((*this)[i], decimals);
+  }
+
+ private:
+  const char* _argv[N];
+  uint8_t _n;
+};
+
+#endif
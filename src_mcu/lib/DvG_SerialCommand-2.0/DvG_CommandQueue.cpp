@@ -0,0 +1,64 @@
+#include "DvG_CommandQueue.h"
+
+#include <string.h>
+
+DvG_CommandQueueBase::DvG_CommandQueueBase(char* strings, uint16_t strSize) {
+  _n = 0;
+  _strings = strings;
+  _strSize = strSize;
+}
+
+bool DvG_CommandQueueBase::parse(const char* strCmd, uint64_t& t,
+                                 const char*& command) {
+  const char* c = strCmd;
+
+  if (*c++ != '@') return false;
+  if (*c < '0' || *c > '9') return false;
+  t = 0;
+  for (; *c >= '0' && *c <= '9'; c++) {
+    uint8_t digit = *c - '0';
+    if (t > (UINT64_MAX - digit) / 10) return false; // Would overflow
+    t = t * 10 + digit;
+  }
+  if (*c != ' ') return false;
+  while (*c == ' ') c++;
+  if (*c == '\0') return false;
+  command = c;
+  return true;
+}
+
+bool DvG_CommandQueueBase::fits(const char* command) {
+  return strlen(command) < _strSize;
+}
+
+bool DvG_CommandQueueBase::push(uint64_t t, const char* command,
+                                uint8_t tag) {
+  bool used[CMDQ_LEN] = {false};
+  uint8_t i, free_slot;
+
+  if (_n >= CMDQ_LEN || !fits(command)) return false;
+
+  // The strings stay put, only the small entries get sorted
+  for (i = 0; i < _n; i++) used[_entries[i].slot] = true;
+  for (free_slot = 0; used[free_slot]; free_slot++) {}
+  strcpy(slot(free_slot), command);
+
+  // Insert behind all entries due at or before `t`
+  for (i = _n; i > 0 && _entries[i - 1].t > t; i--) {
+    _entries[i] = _entries[i - 1];
+  }
+  _entries[i].t = t;
+  _entries[i].slot = free_slot;
+  _entries[i].tag = tag;
+  _n++;
+  return true;
+}
+
+bool DvG_CommandQueueBase::pop(uint64_t& t, char* command) {
+  if (_n == 0) return false;
+  t = _entries[0].t;
+  strcpy(command, slot(_entries[0].slot));
+  _n--;
+  memmove(&_entries[0], &_entries[1], _n * sizeof(Entry));
+  return true;
+}
@@ -0,0 +1,100 @@
+/*
+Small time-ordered queue of commands that are to be executed at a given
+moment instead of right away, for synchronizing the rig with cameras and
+other instruments. A time-tagged command looks like
+
+  @<t> <command>      e.g. "@12500000 f2.33"
+
+where <t> is the device clock in [us], see `micros64()` in main.cpp, and
+<command> any regular command. Commands due at the same time keep their
+order of arrival.
+
+The queue only stores and orders the commands, it is up to the caller to
+decide when one is due, e.g. at the step boundary nearest to its time.
+
+Arduino-free on purpose, so that the host tools can include it.
+*/
+
+#ifndef DvG_CommandQueue_h
+#define DvG_CommandQueue_h
+
+#include <stdint.h>
+
+// Number of commands that can be waiting
+#define CMDQ_LEN 8
+
+// Maximum length of a command of `DvG_CommandQueue` including the '\0'
+// terminator, matches `STR_LEN` in `DvG_SerialCommand.h`
+#define CMDQ_STR_LEN 32
+
+// All of the queue except its command storage, see `DvG_CommandQueueT`
+class DvG_CommandQueueBase {
+ public:
+  // Split a time-tagged command "@<t> <command>" into its time and command.
+  // Returns false when `strCmd` is not of that form, or `<t>` does not fit
+  // 64 bits.
+  static bool parse(const char* strCmd, uint64_t& t, const char*& command);
+
+  // Insert `command` to be executed at `t` [us]. The `tag` is kept along,
+  // e.g. the port the command came in on. Returns false when the queue is
+  // full or the command too long, see `fits()`.
+  bool push(uint64_t t, const char* command, uint8_t tag = 0);
+
+  // Remove the earliest command, copying it into `command`, which must hold
+  // `strSize()` bytes. Returns false when the queue is empty.
+  bool pop(uint64_t& t, char* command);
+
+  // Whether `command` fits the storage of an entry
+  bool fits(const char* command);
+
+  void clear() { _n = 0; }
+
+  bool empty() { return _n == 0; }
+  uint8_t size() { return _n; }
+
+  // Size of the storage of each command, including the '\0' terminator
+  uint16_t strSize() { return _strSize; }
+
+  // Time [us] of the earliest command, only valid when not empty
+  uint64_t nextTime() { return _entries[0].t; }
+
+  // Tag of the earliest command, only valid when not empty
+  uint8_t nextTag() { return _entries[0].tag; }
+
+ protected:
+  DvG_CommandQueueBase(char* strings, uint16_t strSize);
+
+ private:
+  struct Entry {
+    uint64_t t;    // [us]
+    uint8_t slot;  // Index of the command in `_strings`
+    uint8_t tag;
+  };
+
+  Entry _entries[CMDQ_LEN];  // Sorted by time, earliest first
+  uint8_t _n;
+  char* _strings;            // `CMDQ_LEN` commands of `_strSize` bytes each
+  uint16_t _strSize;
+
+  char* slot(uint8_t i) { return &_strings[i * _strSize]; }
+};
+
+// Queue of commands of up to N characters, including the '\0' terminator.
+// Size it like the listener the commands come from, e.g.
+//
+//   DvG_SerialCommandT<CMD_LEN> sc(Serial);
+//   DvG_CommandQueueT<CMD_LEN>  cmd_queue;
+template <uint16_t N>
+class DvG_CommandQueueT : public DvG_CommandQueueBase {
+ public:
+  static_assert(N >= 2, "A command needs room for at least one character");
+
+  DvG_CommandQueueT() : DvG_CommandQueueBase(&_buf[0][0], N) {}
+
+ private:
+  char _buf[CMDQ_LEN][N];
+};
+
+typedef DvG_CommandQueueT<CMDQ_STR_LEN> DvG_CommandQueue;
+
+#endif
@@ -0,0 +1,79 @@
+#include "DvG_CommandRegistry.h"
+
+DvG_CommandRegistry::DvG_CommandRegistry(const DvG_Command* table, uint8_t n,
+                                         DvG_CommandFunc fallback) {
+  uint8_t c;
+
+  _table = table;
+  _n = (n > CMD_N_MAX ? CMD_N_MAX : n);
+  _fallback = fallback;
+  memset(_first, 0, sizeof(_first));
+  memset(_next, 0, sizeof(_next));
+
+  // Push to the front of the chains in reverse table order, prefixes first,
+  // so that each chain holds the exact names in table order followed by the
+  // prefixes in table order
+  for (uint8_t pass = 0; pass < 2; pass++) {
+    for (uint8_t i = _n; i-- > 0;) {
+      if (_table[i].prefix != (pass == 0)) continue;
+      c = _table[i].name[0];
+      if (c < 0x20 || c >= 0x80) continue;  // Can never match
+      _next[i] = _first[c - 0x20];
+      _first[c - 0x20] = i + 1;
+    }
+  }
+  resetStats();
+}
+
+int8_t DvG_CommandRegistry::find(const char* strCmd) {
+  uint8_t c = strCmd[0];
+  uint8_t i;
+
+  if (c < 0x20 || c >= 0x80) return -1;
+  for (i = _first[c - 0x20]; i; i = _next[i - 1]) {
+    const DvG_Command& cmd = _table[i - 1];
+    if (cmd.prefix ? strncmp(strCmd, cmd.name, strlen(cmd.name)) == 0
+                   : strcmp(strCmd, cmd.name) == 0) {
+      return i - 1;
+    }
+  }
+  return -1;
+}
+
+int8_t DvG_CommandRegistry::dispatch(char* strCmd) {
+  int8_t i = find(strCmd);
+  uint32_t t_start = micros();
+  uint32_t duration;
+
+  if (i >= 0) {
+    _table[i].func(strCmd);
+  } else if (_fallback) {
+    _fallback(strCmd);
+  }
+  duration = micros() - t_start;
+
+  Stats& stats = _stats[i >= 0 ? i : _n];
+  stats.count++;
+  stats.time_sum += duration;
+  if (duration > stats.time_max) stats.time_max = duration;
+  return i;
+}
+
+void DvG_CommandRegistry::print(Print& out) {
+  for (uint8_t i = 0; i <= _n; i++) {
+    Stats& stats = _stats[i];
+    if (stats.count == 0) continue;
+    out.print("cmd ");
+    out.print(i < _n ? _table[i].name : "other");
+    out.print(" n ");
+    out.print(stats.count);
+    out.print(" avg ");
+    out.print(stats.time_sum / stats.count);
+    out.print(" max ");
+    out.println(stats.time_max);
+  }
+}
+
+void DvG_CommandRegistry::resetStats() {
+  memset(_stats, 0, sizeof(_stats));
+}
@@ -0,0 +1,78 @@
+/*
+Table-driven dispatch of the commands received by DvG_SerialCommand. The
+commands are listed in a constant table, each with its name and handler:
+
+  const DvG_Command commands[] = {
+    {"?", false, cmd_identify},
+    {"f", true, cmd_speed},     // Prefix: also matches "f2.5"
+  };
+  static_assert(2 <= CMD_N_MAX, "Too many commands, raise CMD_N_MAX");
+  DvG_CommandRegistry registry(commands, 2, cmd_unknown);
+
+  registry.dispatch(sc.getCmd());
+
+Lookup goes through a jump table on the first character, built once by the
+constructor, so it only compares against the few commands sharing that first
+character instead of the whole table. Exact names are tried before prefixes.
+Commands without a match go to the fallback handler.
+
+Every handler call is counted and timed, so slow handlers show up in
+'print()'.
+*/
+
+#ifndef H_DvG_CommandRegistry
+#define H_DvG_CommandRegistry
+
+#include <Arduino.h>
+
+// Maximum number of commands in the table. Entries beyond are never found,
+// so check the size of the table against it where the table is registered.
+#define CMD_N_MAX 32
+
+// Handlers receive the complete command string, so prefix commands can parse
+// their argument from behind the name
+typedef void (*DvG_CommandFunc)(char* strCmd);
+
+struct DvG_Command {
+  const char* name;
+  bool prefix;            // Also match commands that start with `name`
+  DvG_CommandFunc func;
+};
+
+class DvG_CommandRegistry {
+ public:
+  DvG_CommandRegistry(const DvG_Command* table, uint8_t n,
+                      DvG_CommandFunc fallback);
+
+  // Return the table index of the command matching `strCmd`, or -1
+  int8_t find(const char* strCmd);
+
+  // Run the handler of `strCmd`, or the fallback when there is no match.
+  // Returns the table index, or -1 for the fallback.
+  int8_t dispatch(char* strCmd);
+
+  // Print the statistics of all commands called at least once, the fallback
+  // as "other":
+  //   cmd <name> n <count> avg <us> max <us>
+  void print(Print& out);
+
+  void resetStats();
+
+ private:
+  struct Stats {
+    uint32_t count;
+    uint32_t time_sum;  // [us]
+    uint32_t time_max;  // [us]
+  };
+
+  const DvG_Command* _table;
+  uint8_t _n;
+  DvG_CommandFunc _fallback;
+  uint8_t _first[96];         // Per first character ' ' to DEL: table index
+                              // + 1 of the first command in its chain, 0: none
+  uint8_t _next[CMD_N_MAX];   // Table index + 1 of the next command in the
+                              // same chain, 0: end of chain
+  Stats _stats[CMD_N_MAX + 1];  // The fallback last
+};
+
+#endif
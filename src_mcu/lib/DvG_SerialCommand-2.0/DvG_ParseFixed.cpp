@@ -0,0 +1,81 @@
+#include "DvG_ParseFixed.h"
+
+#define FIXED_MAX 2147483647
+#define MANT_DIGITS 18 // Significant digits kept, the rest is truncated
+
+static inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+int32_t dvgParseFixed(const char *str, uint8_t decimals, const char **end) {
+  const char *p = str;
+  uint64_t mant = 0;    // Significant digits
+  uint8_t n_digits = 0; // Significant digits in `mant`
+  int16_t exp10 = 0;    // Value = mant * 10^exp10
+  int16_t exp_arg = 0;
+  bool neg = false;
+  bool neg_exp;
+  bool any = false;
+
+  if (end) *end = str;
+
+  while (*p == ' ' || (*p >= '\t' && *p <= '\r')) p++;
+  if (*p == '+' || *p == '-') neg = (*p++ == '-');
+
+  for (; isDigit(*p); p++) {
+    any = true;
+    if (n_digits < MANT_DIGITS) {
+      mant = mant * 10 + (*p - '0');
+      if (mant) n_digits++;
+    } else {
+      exp10++;
+    }
+  }
+  if (*p == '.') {
+    for (p++; isDigit(*p); p++) {
+      any = true;
+      if (n_digits < MANT_DIGITS) {
+        mant = mant * 10 + (*p - '0');
+        if (mant) n_digits++;
+        exp10--;
+      }
+    }
+  }
+  if (!any) return 0;
+
+  if (*p == 'e' || *p == 'E') {
+    const char *q = p + 1;
+    neg_exp = false;
+    if (*q == '+' || *q == '-') neg_exp = (*q++ == '-');
+    if (isDigit(*q)) {
+      for (; isDigit(*q); q++) {
+        if (exp_arg < 1000) exp_arg = exp_arg * 10 + (*q - '0');
+      }
+      exp10 += (neg_exp ? -exp_arg : exp_arg);
+      p = q;
+    }
+  }
+  if (end) *end = p;
+
+  exp10 += decimals;
+  if (mant == 0) {
+    return 0;
+  } else if (exp10 >= 0) {
+    // Saturates within 10 multiplications, as `mant` is at least 1
+    while (exp10-- > 0 && mant <= FIXED_MAX) mant *= 10;
+  } else if (exp10 < -19) {
+    // `mant` < 10^18 is below half of 10^19
+    mant = 0;
+  } else {
+    uint64_t den = 1;
+    while (exp10++ < 0) den *= 10;
+    if ((mant >> 32) == 0 && (den >> 32) == 0) {
+      // Keep to the cheaper 32-bit division, rounding without overflow
+      uint32_t m = (uint32_t)mant, d = (uint32_t)den;
+      mant = m / d + (m % d >= d - d / 2);
+    } else {
+      mant = mant / den + (mant % den >= den - den / 2);
+    }
+  }
+
+  if (mant > FIXED_MAX) mant = FIXED_MAX;
+  return (neg ? -(int32_t)mant : (int32_t)mant);
+}
@@ -0,0 +1,34 @@
+/*
+Allocation-free parser of decimal numbers into fixed-point integers, for the
+arguments of serial commands. It replaces `atof()`, which pulls in a large
+chunk of libc and parses in soft-float on the FPU-less Cortex-M0+.
+
+Accepts the same syntax as `atof()`, minus hexadecimal, 'inf' and 'nan':
+leading whitespace, an optional sign, digits with an optional decimal point
+and an optional exponent, e.g. "-2.33", ".5", "1e-3", "+4.5E+1". Parsing stops
+at the first character that does not fit.
+
+The result is the value times 10^`decimals`, rounded to the nearest integer
+with halves away from zero and saturated to +/-2147483647. For inputs of up
+to 18 significant digits that is the correctly rounded value. `atof()`
+followed by scaling can only come close to that: a float carries 24 bits,
+so it is off by up to |value| * 2^-24 before the final rounding.
+
+Only integer arithmetic is used. Inputs with no more fraction digits than
+`decimals` do not even need a division.
+
+Arduino-free on purpose, so that the host tools can include it.
+*/
+
+#ifndef DvG_ParseFixed_h
+#define DvG_ParseFixed_h
+
+#include <stdint.h>
+
+// Parse `str` into a fixed-point integer with `decimals` decimal places.
+// When `end` is given, it receives the position right after the parsed
+// number, or `str` when there was no number, in which case 0 is returned.
+int32_t dvgParseFixed(const char *str, uint8_t decimals,
+                      const char **end = 0);
+
+#endif
@@ -4,51 +4,163 @@ Dennis van Gils, 11-03-2020
 
 #include "DvG_SerialCommand.h"
 
-DvG_SerialCommand::DvG_SerialCommand(Stream& mySerial) :
+DvG_SerialCommandBase::DvG_SerialCommandBase(Stream& mySerial, char* strIn,
+                                             uint16_t strLen) :
 _port(mySerial)   // Initialise reference before body
 {
+  _strIn = strIn;
+  _strLen = strLen;
   _strIn[0] = '\0';
   _fTerminated = false;
   _iPos = 0;
+  _tRx = 0;
+  _fBinary = false;
+  _fBinOverflow = false;
+  _fFrame = false;
+  _iBin = 0;
+  _frameLen = 0;
+  _nFrames = 0;
+  _nFrameErrors = 0;
+  _rxHead = 0;
+  _rxTail = 0;
 }
 
-bool DvG_SerialCommand::available() {
-  char c;
+// Copy up to RX_BUDGET characters from the serial port into the ring buffer,
+// in at most two chunks when wrapping around the end
+void DvG_SerialCommandBase::fill() {
+  uint16_t n = _port.available();
+  uint16_t space = RX_LEN - (uint16_t) (_rxHead - _rxTail);
+  uint16_t i, chunk;
 
-  // Poll serial buffer
-  if (_port.available()) {
-    _fTerminated = false;
-    while (_port.available()) {
-      c = _port.peek();
-      if (c == 13) {
+  if (n > space) n = space;
+  if (n > RX_BUDGET) n = RX_BUDGET;
+  while (n > 0) {
+    i = _rxHead & (RX_LEN - 1);
+    chunk = (n < RX_LEN - i ? n : RX_LEN - i);
+    chunk = readPort((char*) _rx + i, chunk);
+    if (chunk == 0) break;
+    _rxHead += chunk;
+    n -= chunk;
+  }
+}
+
+// True when any byte of word `v` is zero
+#define HAS_ZERO_BYTE(v) (((v) - 0x01010101UL) & ~(v) & 0x80808080UL)
+
+// Return the index of the first linefeed or 0x00 in [i, end) of the ring
+// buffer, or `end` when there is none. Whole aligned words are checked four
+// characters at a time.
+uint16_t DvG_SerialCommandBase::findTerminator(uint16_t i, uint16_t end) {
+  uint32_t v;
+  uint8_t c;
+
+  while (i != end) {
+    if (((i & 3) == 0) && ((uint16_t) (end - i) >= 4)) {
+      v = _rx[(i & (RX_LEN - 1)) >> 2];
+      if (!HAS_ZERO_BYTE(v) && !HAS_ZERO_BYTE(v ^ 0x0A0A0A0AUL)) {
+        i += 4;
+        continue;
+      }
+    }
+    c = rxByte(i);
+    if (c == 10 || c == 0) break;
+    i++;
+  }
+  return i;
+}
+
+// Decode the binary frame received between the delimiters. Return true when
+// it is valid.
+bool DvG_SerialCommandBase::terminateFrame() {
+  int16_t len = (_fBinOverflow ? -1 : dvgFrameDecode(_binIn, _iBin));
+  _fBinary = false;
+  if (len < 0 || len > DVG_FRAME_PAYLOAD) {
+    _nFrameErrors++;
+    return false;
+  }
+  _nFrames++;
+  _frameLen = len;
+  _fFrame = true;
+  _fTerminated = true;
+  _tRx = micros();
+  return true;
+}
+
+bool DvG_SerialCommandBase::available() {
+  uint16_t end;
+  uint8_t c;
+
+  if (_fTerminated) {
+    return true;                  // Not retrieved yet
+  }
+  fill();
+
+  while (_rxTail != _rxHead) {
+    // Append the characters up to the next terminator
+    end = findTerminator(_rxTail, _rxHead);
+    for (; _rxTail != end; _rxTail++) {
+      c = rxByte(_rxTail);
+      if (_fBinary) {
+        if (_iBin < sizeof(_binIn)) {
+          _binIn[_iBin] = c;
+          _iBin++;
+        } else {
+          _fBinOverflow = true;
+        }
+      } else if (c == 13) {
         // Ignore ASCII 13 (carriage return)
-        _port.read();             // Remove char from serial buffer
-      } else if (c == 10) {
-        // Found the proper termination character ASCII 10 (line feed)
-        _port.read();             // Remove char from serial buffer
-        _strIn[_iPos] = '\0';     // Terminate string
-        _fTerminated = true;
-        break;
-      } else if (_iPos < STR_LEN - 1) {
-        // Maximum length of incoming serial command is not yet reached. Append
-        // characters to string.
-        _port.read();             // Remove char from serial buffer
+      } else if (_iPos < _strLen - 1) {
+        // Maximum length of incoming serial command is not yet reached.
+        // Append characters to string.
         _strIn[_iPos] = c;
         _iPos++;
       } else {
         // Maximum length of incoming serial command is reached. Forcefully
-        // terminate string now. Leave the char in the serial buffer.
+        // terminate string now. Leave the char in the ring buffer.
         _strIn[_iPos] = '\0';     // Terminate string
         _fTerminated = true;
-        break;
+        _tRx = micros();
+        return true;
       }
     }
+    if (_rxTail == _rxHead) break;
+
+    // Handle the terminator
+    c = rxByte(_rxTail);
+    _rxTail++;
+    if (c == 10) {
+      if (_fBinary) {
+        // Just data inside a binary frame
+        if (_iBin < sizeof(_binIn)) {
+          _binIn[_iBin] = c;
+          _iBin++;
+        } else {
+          _fBinOverflow = true;
+        }
+      } else {
+        // Found the proper termination character ASCII 10 (line feed)
+        _strIn[_iPos] = '\0';     // Terminate string
+        _fTerminated = true;
+        _tRx = micros();
+        return true;
+      }
+    } else if (!_fBinary) {
+      // Opening delimiter of a binary frame. Drops any partial command.
+      _fBinary = true;
+      _fBinOverflow = false;
+      _iBin = 0;
+      _iPos = 0;
+    } else if (_iBin > 0 || _fBinOverflow) {
+      // Closing delimiter
+      if (terminateFrame()) return true;
+    }
+    // A 0x00 right after the opening one is an empty frame: skip it
   }
-  return _fTerminated;
+  return false;
 }
 
-char* DvG_SerialCommand::getCmd() {
-  if (_fTerminated) {
+char* DvG_SerialCommandBase::getCmd() {
+  if (_fTerminated && !_fFrame) {
     _fTerminated = false;     // Reset incoming serial command char array
     _iPos = 0;                // Reset incoming serial command char array
     return (char*) _strIn;
@@ -57,14 +169,27 @@ char* DvG_SerialCommand::getCmd() {
   }
 }
 
+const uint8_t* DvG_SerialCommandBase::getFrame(uint8_t& len) {
+  if (_fTerminated && _fFrame) {
+    _fTerminated = false;
+    _fFrame = false;
+    len = _frameLen;
+    return _binIn;
+  } else {
+    len = 0;
+    return NULL;
+  }
+}
+
 /*------------------------------------------------------------------------------
-    Parse float value at end of string 'strIn' starting at position 'iPos'
+    Parse decimal value at end of string 'strIn' starting at position 'iPos'
+    into a fixed-point integer with 'decimals' decimal places
 ------------------------------------------------------------------------------*/
 
-float parseFloatInString(char* strIn, uint8_t iPos) {
-  if (strlen(strIn) > iPos) {
-    return (float) atof(&strIn[iPos]);
-  } else {
-    return 0.0f;
+int32_t parseFixedInString(const char* strIn, uint8_t iPos, uint8_t decimals) {
+  // Only look as far as 'iPos', instead of taking the full 'strlen()'
+  for (uint8_t i = 0; i < iPos; i++) {
+    if (strIn[i] == '\0') return 0;
   }
+  return dvgParseFixed(&strIn[iPos], decimals);
 }
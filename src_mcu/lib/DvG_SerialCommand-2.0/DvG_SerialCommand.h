@@ -4,9 +4,34 @@ upon them. To keep the memory usage low, it uses a C-string (null-terminated
 character array) to store incoming characters received over the serial port,
 instead of using a memory hungry C++ string. Carriage return ('\r', ASCII 13)
 characters are ignored. Once a linefeed ('\n', ASCII 10) character is received,
-or whenever the incoming message length has exceeded the buffer of size
-STR_LEN (defined in DvG_SerialCommand.h), we speak of a received 'command'.
-It doesn't matter if the command is ASCII or binary encoded.
+or whenever the incoming message length has exceeded the buffer of size N,
+we speak of a received 'command'. It doesn't matter if the command is ASCII
+or binary encoded.
+
+The buffer size is a template argument, so it is fixed at compile time
+without any allocation:
+
+  DvG_SerialCommandT<64> sc(Serial);
+
+The optional second argument is the type of the port. Naming it lets the
+bulk copy use that port's own 'readBytes()', where the generic one of
+'Stream' reads byte by byte. The native USB port has such a bulk read:
+
+  DvG_SerialCommandT<64, Serial_> sc_usb(SerialUSB);
+
+'DvG_SerialCommand' remains available as the listener with the former fixed
+buffer of STR_LEN characters. Arguments are split off in place by
+'DvG_CommandArgs', see DvG_CommandArgs.h.
+
+Incoming characters are copied from the serial port in bulk, at most RX_BUDGET
+per call to 'available()', into a ring buffer of RX_LEN. The ring buffer is
+then searched for the next terminator a word at a time. A burst of commands
+thus gets queued in one go, and is handed out one command per call.
+
+A 0x00 character starts a binary frame instead, see DvG_BinaryFrame.h, which
+ends at the next 0x00. Frames that pass their CRC check are reported by
+'available()' as well, and retrieved by calling 'getFrame()'. Frames failing
+the check are dropped and counted.
 
 'available()' should be called periodically to poll for incoming characters. It
 will return true when a new command is ready to be processed. Subsequently, the
@@ -20,35 +45,116 @@ Dennis van Gils, 11-03-2020
 
 #include <Arduino.h>
 
-// Buffer size for storing incoming characters. Includes the '\0' termination
-// character. Change buffer size to your needs up to a maximum of 255.
+#include "DvG_BinaryFrame.h"
+#include "DvG_ParseFixed.h"
+
+// Buffer size of `DvG_SerialCommand` for storing incoming characters.
+// Includes the '\0' termination character.
 #define STR_LEN 32
 
-class DvG_SerialCommand {
- public:
-  DvG_SerialCommand(Stream& mySerial);
+// Ring buffer size for incoming characters, a power of 2
+#define RX_LEN 256
 
+// Maximum number of characters copied from the serial port per call to
+// 'available()', bounding its duration
+#define RX_BUDGET 64
+
+// All of the listener except its command buffer, see `DvG_SerialCommandT`
+class DvG_SerialCommandBase {
+ public:
   // Poll the serial port for characters and append to buffer. Return true if
-  // a command is ready to be processed.
+  // a command is ready to be processed. A command that has not been retrieved
+  // yet stays available.
   bool available();
 
   // Return the incoming serial command only when it is ready, otherwise return
   // an empty C-string.
   char* getCmd();
 
+  // Return the payload of the incoming binary frame and its length only when
+  // it is ready, otherwise return NULL. The payload stays valid until the
+  // next call to 'available()'.
+  const uint8_t* getFrame(uint8_t& len);
+
+  // Frames received and frames dropped for a COBS, CRC or length error
+  uint32_t framesReceived() { return _nFrames; }
+  uint32_t frameErrors() { return _nFrameErrors; }
+  void resetFrameCounters() { _nFrames = 0; _nFrameErrors = 0; }
+
+  // Return the `micros()` timestamp at which the most recent command got
+  // terminated, i.e. taken out of the ring buffer. Useful for measuring the
+  // latency of command handling.
+  uint32_t rxTime() { return _tRx; }
+
+  // Size of the command buffer, including the '\0' termination character
+  uint16_t bufferSize() { return _strLen; }
+
+ protected:
+  DvG_SerialCommandBase(Stream& mySerial, char* strIn, uint16_t strLen);
+
+  // Copy up to `n` characters that are known to be available from the port
+  virtual size_t readPort(char* buffer, size_t n) = 0;
+
  private:
   Stream& _port;              // Serial port reference
-  char    _strIn[STR_LEN];    // Incoming serial command string
+
+  // Ring buffer, words for the aligned search, see findTerminator()
+  uint32_t _rx[RX_LEN / 4];
+  uint16_t _rxHead;           // Free-running write index
+  uint16_t _rxTail;           // Free-running read index
+  inline uint8_t rxByte(uint16_t i) {
+    return ((uint8_t*) _rx)[i & (RX_LEN - 1)];
+  }
+  void fill();
+  uint16_t findTerminator(uint16_t i, uint16_t end);
+  bool terminateFrame();
+  char*   _strIn;             // Incoming serial command string
+  uint16_t _strLen;           // Size of _strIn
   bool    _fTerminated;       // Incoming serial command is/got terminated?
-  uint8_t _iPos;              // Index within _strIn to insert new char
+  uint16_t _iPos;             // Index within _strIn to insert new char
+  uint32_t _tRx;              // [us] Time at which the command got terminated
   const char* _empty = "\0";  // Reply when trying to retrieve command when not
                               // yet terminated
+
+  // Binary frame, encoded bytes between the delimiters, decoded in place
+  uint8_t _binIn[DVG_FRAME_ENCODED(DVG_FRAME_PAYLOAD) - 2];
+  bool    _fBinary;           // Receiving a binary frame?
+  bool    _fBinOverflow;      // Incoming frame exceeds _binIn?
+  bool    _fFrame;            // Terminated command is a binary frame?
+  uint8_t _iBin;              // Index within _binIn to insert new byte
+  uint8_t _frameLen;          // Payload length of the decoded frame
+  uint32_t _nFrames;
+  uint32_t _nFrameErrors;
 };
 
+// Listener with a command buffer of N characters, including the '\0'
+// termination character, on a port of type `PortT`
+template <uint16_t N, class PortT = Stream>
+class DvG_SerialCommandT : public DvG_SerialCommandBase {
+ public:
+  static_assert(N >= 2, "A command needs room for at least one character");
+
+  DvG_SerialCommandT(PortT& mySerial)
+      : DvG_SerialCommandBase(mySerial, _buf, N), _typedPort(mySerial) {}
+
+ protected:
+  size_t readPort(char* buffer, size_t n) {
+    return _typedPort.readBytes(buffer, n);
+  }
+
+ private:
+  PortT& _typedPort;
+  char _buf[N];
+};
+
+typedef DvG_SerialCommandT<STR_LEN> DvG_SerialCommand;
+
 /*------------------------------------------------------------------------------
-    Parse float value at end of string 'strIn' starting at position 'iPos'
+    Parse decimal value at end of string 'strIn' starting at position 'iPos'
+    into a fixed-point integer with 'decimals' decimal places, see
+    DvG_ParseFixed.h. Avoids 'atof()' and float arithmetic altogether.
 ------------------------------------------------------------------------------*/
 
-float parseFloatInString(char* strIn, uint8_t iPos);
+int32_t parseFixedInString(const char* strIn, uint8_t iPos, uint8_t decimals);
 
 #endif
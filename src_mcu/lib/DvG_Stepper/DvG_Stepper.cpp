@@ -22,8 +22,16 @@ DvG_Stepper::DvG_Stepper(Adafruit_StepperMotor *stepper,
   _targetPos = 0;
   _speed_rev_per_sec = 0.0;
   _speed_steps_per_sec = 0.0;
+  _speed_fixed = 0;
+  _fSpeedFixed = false;
+  _fStopped = true;
   _stepInterval = 0;
   _lastStepTime = 0;
+  _fNewSpeed = false;
+  _fNewSpeedStepped = false;
+  _tNewSpeedStep = 0;
+  _fJitter = false;
+  resetJitter();
 
   // Set up direct port manipulation for the trigger-out signals
   volatile uint32_t *mode;
@@ -41,7 +49,10 @@ DvG_Stepper::DvG_Stepper(Adafruit_StepperMotor *stepper,
   _set_trig_beat_LO();      // Set pin to low
 }
 
-void DvG_Stepper::turn_on() { _running = true; }
+void DvG_Stepper::turn_on() {
+  _running = true;
+  _fJitter = false;
+}
 
 void DvG_Stepper::turn_off() {
   _running = false;
@@ -75,7 +86,11 @@ void DvG_Stepper::setStyle(uint8_t style) {
   _set_trig_beat_LO();
 
   // Must recalculate the steps per second
-  setSpeed(_speed_rev_per_sec);
+  if (_fSpeedFixed) {
+    setSpeedFixed(_speed_fixed);
+  } else {
+    setSpeed(_speed_rev_per_sec);
+  }
 }
 
 uint8_t DvG_Stepper::style() { return _style; }
@@ -98,16 +113,74 @@ void DvG_Stepper::setCurrentPosition(int32_t position) {
 void DvG_Stepper::setSpeed(float rev_per_sec) {
   _speed_rev_per_sec = rev_per_sec;
   _speed_steps_per_sec = rev_per_sec * (_steps_per_rev * _steps_per_beat / 2);
-  _stepInterval = abs(1000000. / _speed_steps_per_sec);
+  _fStopped = (_speed_steps_per_sec == 0);
+  if (_fStopped) {
+    _stepInterval = 0xFFFFFFFF;
+  } else {
+    _stepInterval = abs(1000000. / _speed_steps_per_sec);
+  }
+
+  // Account for overhead I2C communication
+  if (_stepInterval < STEPPER_I2C_OVERHEAD) {
+    _stepInterval = STEPPER_I2C_OVERHEAD;
+  }
+  _stepInterval -= STEPPER_I2C_OVERHEAD;
+
+  _fSpeedFixed = false;
+  _fNewSpeed = true;
+  _fNewSpeedStepped = false;
+  _fJitter = false;
+}
+
+void DvG_Stepper::setSpeedFixed(int32_t speed) {
+  uint32_t steps_per_rev = (uint32_t)_steps_per_rev * _steps_per_beat / 2;
+  uint64_t steps_per_sec; // [usteps per sec]
+  uint64_t interval;
+
+  // Floats only for reporting, not for the step interval
+  _speed_rev_per_sec = (float)speed / STEPPER_SPEED_ONE;
+  _speed_steps_per_sec = _speed_rev_per_sec * steps_per_rev;
+
+  steps_per_sec = (uint64_t)(speed < 0 ? -(int64_t)speed : speed) *
+                  steps_per_rev;
+  interval = (steps_per_sec
+                  ? 1000000ULL * STEPPER_SPEED_ONE / steps_per_sec
+                  : 0xFFFFFFFF);
+  _stepInterval = (interval > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)interval);
 
   // Account for overhead I2C communication
-  _stepInterval -= 3; // 3 usec
+  if (_stepInterval < STEPPER_I2C_OVERHEAD) {
+    _stepInterval = STEPPER_I2C_OVERHEAD;
+  }
+  _stepInterval -= STEPPER_I2C_OVERHEAD;
+
+  _fStopped = (steps_per_sec == 0);
+  _speed_fixed = speed;
+  _fSpeedFixed = true;
+  _fNewSpeed = true;
+  _fNewSpeedStepped = false;
+  _fJitter = false;
 }
 
 float DvG_Stepper::speed() { return _speed_rev_per_sec; }
 
 float DvG_Stepper::speed_steps_per_sec() { return _speed_steps_per_sec; }
 
+uint32_t DvG_Stepper::steps_per_rev() {
+  return (uint32_t)_steps_per_rev * _steps_per_beat / 2;
+}
+
+uint8_t DvG_Stepper::steps_per_beat() { return _steps_per_beat; }
+
+bool DvG_Stepper::newSpeedStepped(uint32_t &time) {
+  if (!_fNewSpeedStepped) {
+    return false;
+  }
+  _fNewSpeedStepped = false;
+  time = _tNewSpeedStep;
+  return true;
+}
+
 void DvG_Stepper::step() {
   _stepper->onestep(_speed_rev_per_sec > 0 ? FORWARD : BACKWARD, _style);
   _toggle_trig_step();
@@ -139,9 +212,24 @@ bool DvG_Stepper::runSpeed() {
   // You must call this at least once per step
   // Returns true if a step occurred
 
+  // At speed 0 the interval would still run out once every ~71.6 min
+  if (_fStopped) {
+    return false;
+  }
+
   uint32_t time = micros();
 
-  if (time > _lastStepTime + _stepInterval) {
+  // Compare elapsed time instead of absolute timestamps, so that the unsigned
+  // subtraction stays correct when `micros()` wraps around every ~71.6 min.
+  if (time - _lastStepTime > _stepInterval) {
+    if (_fJitter) {
+      uint32_t late = time - _lastStepTime - _stepInterval - 1;
+      _jitterCount++;
+      _jitterSum += late;
+      if (late > _jitterMax) _jitterMax = late;
+    }
+    _fJitter = true;
+
     if (_speed_rev_per_sec > 0) {
       _currentPos += 1;
       step();
@@ -151,11 +239,31 @@ bool DvG_Stepper::runSpeed() {
     }
 
     _lastStepTime = time;
+    if (_fNewSpeed) {
+      _fNewSpeed = false;
+      _fNewSpeedStepped = true;
+      _tNewSpeedStep = time;
+    }
     return true;
   } else
     return false;
 }
 
+void DvG_Stepper::resetJitter() {
+  _jitterCount = 0;
+  _jitterSum = 0;
+  _jitterMax = 0;
+}
+
+uint32_t DvG_Stepper::timeUntilNextStep() {
+  if (!_running || _fStopped) {
+    return 0xFFFFFFFF;
+  }
+
+  uint32_t elapsed = micros() - _lastStepTime;
+  return (elapsed > _stepInterval ? 0 : _stepInterval - elapsed + 1);
+}
+
 void DvG_Stepper::runToPosition() {
   // Blocks until the target position is reached
   while (run())
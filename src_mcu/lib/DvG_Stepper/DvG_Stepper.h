@@ -34,6 +34,13 @@ Heavily modified code from:
 #define PIN_TRIG_STEP 12
 #define PIN_TRIG_BEAT 13
 
+// Fixed-point speed of `setSpeedFixed()`: 1 rev per sec, i.e. [urev per sec]
+#define STEPPER_SPEED_DECIMALS 6
+#define STEPPER_SPEED_ONE 1000000L
+
+// Taken off the step interval for the I2C transfer of each step [us]
+#define STEPPER_I2C_OVERHEAD 3
+
 class DvG_Stepper {
 public:
   /// Constructor. You can have multiple simultaneous steppers, all moving
@@ -90,12 +97,35 @@ public:
   /// Positive is clockwise.
   void setSpeed(float speed);
 
+  /// Same as setSpeed(), but in fixed point and without float arithmetic on
+  /// the way to the step interval. Pairs with `parseFixedInString()`.
+  /// The step interval is the exact value truncated to whole microseconds.
+  /// The float setSpeed() rounds along the way, so the two may differ by 1 us
+  /// where the exact value is within float precision of a whole microsecond.
+  /// \param[in] speed The desired constant speed in [urev per sec], see
+  /// `STEPPER_SPEED_ONE`. Positive is clockwise.
+  void setSpeedFixed(int32_t speed);
+
   /// \return The speed in [rev per sec]
   float speed();
 
   /// \return The speed in [steps per sec]
   float speed_steps_per_sec();
 
+  /// \return The number of steps making up one revolution in the current
+  /// stepping style, i.e. including interleaved and micro steps
+  uint32_t steps_per_rev();
+
+  /// \return The number of steps making up one beat, see `PIN_TRIG_BEAT`
+  uint8_t steps_per_beat();
+
+  /// Report the first step taken at the new step interval following the most
+  /// recent call to setSpeed() or setStyle(). Used to measure the latency
+  /// between receiving a speed command and acting upon it.
+  /// \param[out] time The `micros()` timestamp of that step.
+  /// \return true only once per speed change, when that step has occurred.
+  bool newSpeedStepped(uint32_t &time);
+
   /// Poll the motor and step it if a step is due, implementing
   /// constant velocity to achive the target position. You must call this as
   /// fequently as possible, but at least once per minimum step interval,
@@ -108,6 +138,22 @@ public:
   /// \return true if the motor was stepped.
   bool runSpeed();
 
+  /// Time left until runSpeed() will take the next step. Lets a scheduler
+  /// judge whether other work fits in before the step is due.
+  /// \return The time in [us], 0 when a step is due or overdue and 0xFFFFFFFF
+  /// when the motor is turned off.
+  uint32_t timeUntilNextStep();
+
+  /// Step jitter: how late each step was taken, compared to the earliest
+  /// moment runSpeed() could have taken it. Steps right after turn_on() or a
+  /// speed change are left out, as they lack a regular predecessor.
+  /// \return The number of steps, the summed and the maximum lateness [us]
+  /// since the last resetJitter().
+  uint32_t getJitterCount() { return _jitterCount; }
+  uint32_t getJitterSum() { return _jitterSum; }
+  uint32_t getJitterMax() { return _jitterMax; }
+  void resetJitter();
+
   /// Moves the motor to the target position and blocks until it is at
   /// position. Dont use this in event loops, since it blocks.
   void runToPosition();
@@ -162,6 +208,20 @@ private:
   // Positive is clockwise
   float _speed_rev_per_sec;
   float _speed_steps_per_sec;
+  int32_t _speed_fixed;   // [urev per sec], when set by setSpeedFixed()
+  bool _fSpeedFixed;      // Speed last set by setSpeedFixed()
+  bool _fStopped;         // Speed 0, runSpeed() never steps
+
+  // Latency stamp of the first step after a speed change
+  bool _fNewSpeed;         // Speed changed, no step taken yet
+  bool _fNewSpeedStepped;  // First step taken, not yet reported
+  uint32_t _tNewSpeedStep; // [us]
+
+  // Step jitter statistics
+  bool _fJitter;           // The previous step was at the current interval
+  uint32_t _jitterCount;
+  uint32_t _jitterSum;     // [us]
+  uint32_t _jitterMax;     // [us]
 
   // For direct port manipulation, instead of the slower 'digitalWrite()'
   uint32_t _mask_trig_step;
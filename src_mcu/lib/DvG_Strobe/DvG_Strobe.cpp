@@ -0,0 +1,101 @@
+#include "DvG_Strobe.h"
+
+DvG_Strobe::DvG_Strobe(DvG_Stepper& stepper, Adafruit_NeoPixel_ZeroDMA& strip)
+    : _stepper(stepper), _strip(strip) {
+  _enabled = false;
+  _passes = 1;
+  _period = 1;
+  _phase = 0;
+  _lo = 0;
+  _last_pos = 0;
+  _osc_period = 0;
+  _t_next = 0;
+}
+
+void DvG_Strobe::setPeriod(uint32_t period, uint32_t phase) {
+  _period = (period ? period : 1);
+  _phase = phase % _period;
+  _osc_period = 0;
+  sync();
+}
+
+void DvG_Strobe::setRevolutionPhase(int32_t phase) {
+  uint32_t period = _stepper.steps_per_rev();
+  int32_t rem = phase % STROBE_PHASE_REV;
+  if (rem < 0) {
+    rem += STROBE_PHASE_REV;
+  }
+  // No overflow up to 119304 steps per revolution
+  setPeriod(period, ((uint32_t)rem * period + STROBE_PHASE_REV / 2) /
+                        STROBE_PHASE_REV);
+}
+
+void DvG_Strobe::setOscillationPhase(uint32_t period, int32_t phase,
+                                     uint32_t t_zero) {
+  int32_t rem = phase % STROBE_PHASE_REV;
+  if (rem < 0) {
+    rem += STROBE_PHASE_REV;
+  }
+  _osc_period = (period ? period : 1);
+  _t_next = t_zero + (uint32_t)((uint64_t)rem * _osc_period /
+                                STROBE_PHASE_REV);
+  if ((int32_t)(micros() - _t_next) > 0) {
+    _t_next += _osc_period; // Already passed in the current period
+  }
+}
+
+void DvG_Strobe::setColors(uint32_t on, uint32_t off) {
+  _strip.setStrobeColors(on, off);
+}
+
+bool DvG_Strobe::enable(bool enable) {
+  if (!_strip.setStrobe(enable)) {
+    return false;
+  }
+  _enabled = enable;
+  sync();
+  return true;
+}
+
+void DvG_Strobe::sync() {
+  // Find the flash position at or below the current position. Division is
+  // fine here, `poll()` only needs compares from now on.
+  _last_pos = _stepper.currentPosition();
+  int32_t rel = _last_pos - _phase;
+  int32_t k = rel / _period;
+  if (rel < 0 && (rel % _period)) {
+    k--; // Round towards minus infinity
+  }
+  _lo = k * _period + _phase;
+}
+
+void DvG_Strobe::poll() {
+  if (!_enabled) {
+    return;
+  }
+  if (_osc_period) {
+    uint32_t now = micros();
+    if ((int32_t)(now - _t_next) >= 0) {
+      _strip.strobeFlash(_passes);
+      // Skip the flashes missed while not polled, e.g. with the motor off
+      uint32_t late = now - _t_next;
+      _t_next += (late / _osc_period + 1) * _osc_period;
+    }
+    return;
+  }
+  int32_t pos = _stepper.currentPosition();
+  if (pos == _last_pos) {
+    return;
+  }
+  _last_pos = pos;
+
+  // The position moves one step at a time, in either direction
+  if (pos >= _lo + _period) {
+    _lo += _period;
+  } else if (pos < _lo) {
+    _lo -= _period;
+  }
+  if (pos == _lo) {
+    _strip.strobeFlash(_passes);
+  }
+}
@@ -0,0 +1,81 @@
+/*
+Stroboscopic illumination phase-locked to the stepper position. Flashes the
+NeoPixel strip each time the stepper arrives at a chosen position within a
+repeating period of steps, in either direction of rotation. Typical periods
+are one revolution, to freeze the cylinder at a chosen angle, or one beat,
+see `DvG_Stepper::steps_per_beat()`.
+
+While the motor oscillates back and forth, a position comes by twice per
+period instead. The strobe can then lock to the phase of the oscillation in
+time, flashing at the first step after each due time.
+
+Each flash is only a DMA source-address swap between pre-expanded 'on' and
+'off' frames, see `Adafruit_NeoPixel_ZeroDMA::strobeFlash()`, so polling
+right after every step costs a few compares and does not slow the stepper.
+The light reaches the LEDs within one pass over the DMA buffer, about 1 ms
+for 16 RGBW pixels.
+
+Usage:
+  DvG_Strobe strobe(Astepper, strip);
+  strobe.setPeriod(Astepper.steps_per_rev(), 0); // Once per rev at 0 deg
+  strobe.enable(true);
+
+  if (Astepper.runSpeed()) {
+    strobe.poll();
+  }
+*/
+
+#ifndef DvG_Strobe_h
+#define DvG_Strobe_h
+
+#include <Arduino.h>
+
+#include "Adafruit_NeoPixel_ZeroDMA.h"
+#include "DvG_Stepper.h"
+
+// Phase angles in fixed point, in [0.01 deg]
+#define STROBE_PHASE_DECIMALS 2
+#define STROBE_PHASE_REV 36000 // One revolution
+
+class DvG_Strobe {
+ public:
+  DvG_Strobe(DvG_Stepper& stepper, Adafruit_NeoPixel_ZeroDMA& strip);
+
+  // Flash at every position `k * period + phase` [steps], k any integer
+  void setPeriod(uint32_t period, uint32_t phase = 0);
+  // Flash once per revolution at `phase` [0.01 deg] in the current stepping
+  // style, rounded to the nearest step. Call again after changing the
+  // stepping style.
+  void setRevolutionPhase(int32_t phase);
+  // Flash once per oscillation `period` [us] at `phase` [0.01 deg] of it.
+  // `t_zero` is a recent `micros()` at which the oscillation was at phase 0.
+  // The period must be below 2^31 us.
+  void setOscillationPhase(uint32_t period, int32_t phase, uint32_t t_zero);
+  // Colors of the strip during and in between flashes, and the minimum
+  // number of DMA passes a flash lasts
+  void setColors(uint32_t on, uint32_t off = 0);
+  void setPasses(uint8_t passes) { _passes = passes; }
+
+  // Returns false when the strip could not enter strobe mode
+  bool enable(bool enable);
+  bool enabled() { return _enabled; }
+
+  // Call after every step of the stepper
+  void poll();
+
+ private:
+  DvG_Stepper& _stepper;
+  Adafruit_NeoPixel_ZeroDMA& _strip;
+  bool _enabled;
+  uint8_t _passes;
+  int32_t _period; // [steps]
+  int32_t _phase;  // [steps]
+  int32_t _lo;     // Flash position with `_lo <= position < _lo + _period`
+  int32_t _last_pos;
+  uint32_t _osc_period; // [us], 0: locked to the position
+  uint32_t _t_next;     // [us] Next flash while locked to the oscillation
+
+  void sync();
+};
+
+#endif
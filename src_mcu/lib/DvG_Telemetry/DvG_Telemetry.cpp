@@ -0,0 +1,163 @@
+#include "DvG_Telemetry.h"
+
+#include <string.h>
+
+static inline uint32_t zigzag(int32_t value) {
+  return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t value) {
+  return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+// Zigzag-mapped difference, wrapping around instead of overflowing
+static inline uint32_t zigzagDiff(uint32_t a, uint32_t b) {
+  return zigzag((int32_t)(a - b));
+}
+
+// Undo `zigzagDiff()`
+static inline uint32_t addZigzag(uint32_t a, uint32_t diff) {
+  return a + (uint32_t)unzigzag(diff);
+}
+
+static uint8_t *putVarint(uint8_t *out, uint32_t value) {
+  while (value >= 0x80) {
+    *out++ = (uint8_t)value | 0x80;
+    value >>= 7;
+  }
+  *out++ = (uint8_t)value;
+  return out;
+}
+
+// Returns false when the varint runs past `end` or exceeds 32 bits
+static bool getVarint(const uint8_t *&in, const uint8_t *end,
+                      uint32_t &value) {
+  value = 0;
+  for (uint8_t shift = 0; shift < 35; shift += 7) {
+    if (in >= end) return false;
+    uint8_t c = *in++;
+    value |= (uint32_t)(c & 0x7F) << shift;
+    if (!(c & 0x80)) return true;
+  }
+  return false;
+}
+
+/*------------------------------------------------------------------------------
+    DvG_TelemetryEncoder
+------------------------------------------------------------------------------*/
+
+DvG_TelemetryEncoder::DvG_TelemetryEncoder() {
+  memset(&_prev, 0, sizeof(_prev));
+  _seq = 0;
+  _sinceKey = TELEM_KEY_EVERY; // Start with a key record
+}
+
+uint8_t DvG_TelemetryEncoder::encode(const DvG_TelemetryRecord &rec,
+                                     uint8_t *payload) {
+  bool key = (_sinceKey >= TELEM_KEY_EVERY - 1);
+  uint8_t *out = payload;
+
+  *out++ = (key ? TELEM_KEY : TELEM_DELTA);
+  *out++ = _seq++;
+  *out++ = (rec.style & 0x07) | (rec.running ? 0x08 : 0);
+  if (key) {
+    out = putVarint(out, rec.t);
+    out = putVarint(out, zigzag(rec.speed));
+    out = putVarint(out, zigzag(rec.position));
+  } else {
+    out = putVarint(out, rec.t - _prev.t);
+    out = putVarint(out, zigzagDiff(rec.speed, _prev.speed));
+    out = putVarint(out, zigzagDiff(rec.position, _prev.position));
+  }
+  out = putVarint(out, rec.jitter_avg);
+  out = putVarint(out, rec.jitter_max);
+  out = putVarint(out, rec.loop_avg);
+  out = putVarint(out, rec.loop_max);
+  if (key) {
+    out = putVarint(out, rec.leds_shown);
+    out = putVarint(out, rec.leds_skipped);
+    out = putVarint(out, rec.leds_deferred);
+    out = putVarint(out, rec.leds_limited);
+  } else {
+    // The counters may get reset in between, hence signed
+    out = putVarint(out, zigzagDiff(rec.leds_shown, _prev.leds_shown));
+    out = putVarint(out, zigzagDiff(rec.leds_skipped, _prev.leds_skipped));
+    out = putVarint(out, zigzagDiff(rec.leds_deferred, _prev.leds_deferred));
+    out = putVarint(out, zigzagDiff(rec.leds_limited, _prev.leds_limited));
+  }
+
+  _sinceKey = (key ? 0 : _sinceKey + 1);
+  _prev = rec;
+  return out - payload;
+}
+
+/*------------------------------------------------------------------------------
+    DvG_TelemetryDecoder
+------------------------------------------------------------------------------*/
+
+DvG_TelemetryDecoder::DvG_TelemetryDecoder() {
+  memset(&_prev, 0, sizeof(_prev));
+  _seq = 0;
+  _fValid = false;
+  _gaps = 0;
+}
+
+bool DvG_TelemetryDecoder::decode(const uint8_t *payload, uint8_t len,
+                                  DvG_TelemetryRecord &rec) {
+  const uint8_t *in = payload + 3;
+  const uint8_t *end = payload + len;
+  uint32_t v[11];
+  bool key;
+
+  if (len < 3 || (payload[0] != TELEM_KEY && payload[0] != TELEM_DELTA)) {
+    return false;
+  }
+  key = (payload[0] == TELEM_KEY);
+  if (_fValid && payload[1] != _seq) {
+    _gaps++;
+    _fValid = false;
+  }
+  _seq = payload[1] + 1;
+  if (!key && !_fValid) {
+    return false;
+  }
+
+  for (uint8_t i = 0; i < 11; i++) {
+    if (!getVarint(in, end, v[i])) {
+      _fValid = false;
+      return false;
+    }
+  }
+  if (in != end) {
+    _fValid = false;
+    return false;
+  }
+
+  rec.style = payload[2] & 0x07;
+  rec.running = (payload[2] & 0x08) != 0;
+  if (key) {
+    rec.t = v[0];
+    rec.speed = unzigzag(v[1]);
+    rec.position = unzigzag(v[2]);
+    rec.leds_shown = v[7];
+    rec.leds_skipped = v[8];
+    rec.leds_deferred = v[9];
+    rec.leds_limited = v[10];
+  } else {
+    rec.t = _prev.t + v[0];
+    rec.speed = (int32_t)addZigzag(_prev.speed, v[1]);
+    rec.position = (int32_t)addZigzag(_prev.position, v[2]);
+    rec.leds_shown = addZigzag(_prev.leds_shown, v[7]);
+    rec.leds_skipped = addZigzag(_prev.leds_skipped, v[8]);
+    rec.leds_deferred = addZigzag(_prev.leds_deferred, v[9]);
+    rec.leds_limited = addZigzag(_prev.leds_limited, v[10]);
+  }
+  rec.jitter_avg = v[3];
+  rec.jitter_max = v[4];
+  rec.loop_avg = v[5];
+  rec.loop_max = v[6];
+
+  _prev = rec;
+  _fValid = true;
+  return true;
+}
@@ -0,0 +1,99 @@
+/*
+Compact binary telemetry records, streamed by the firmware inside binary
+frames, see DvG_BinaryFrame.h, so that a host can log a whole experiment.
+
+A record has a fixed set of fields, `DvG_TelemetryRecord`. On the wire most
+fields are sent as the difference to the previous record, and every number
+as a varint: 7 bits per byte, least significant first, the top bit set on
+all but the last byte. Signed differences are zigzag-mapped first, so that
+small negative numbers stay short: 0, -1, 1, -2, ... map onto 0, 1, 2, 3.
+A typical record thus takes some 20 bytes instead of 50.
+
+Payload layout:
+
+  kind        TELEM_KEY: all fields absolute
+              TELEM_DELTA: `t`, `speed`, `position` and the LED counters as
+              differences to the previous record
+  seq         Sequence number, incremented per record
+  flags       Bits 0-2: style, bit 3: running
+  varints     t, speed, position, jitter_avg, jitter_max, loop_avg,
+              loop_max, leds_shown, leds_skipped, leds_deferred, leds_limited
+
+A delta record can only be decoded on top of its predecessor. Every
+`TELEM_KEY_EVERY`-th record is a key record, so a receiver that missed a
+record, as told by a gap in the sequence numbers, picks up again at the
+next key record.
+
+Arduino-free on purpose, so that the host tools can include it.
+*/
+
+#ifndef DvG_Telemetry_h
+#define DvG_Telemetry_h
+
+#include <stdint.h>
+
+// Payload kinds. Distinct from the operations of the frames sent to the
+// firmware, so that a payload identifies itself.
+#define TELEM_KEY 0x80
+#define TELEM_DELTA 0x81
+
+// Send a key record at least this often [records]
+#define TELEM_KEY_EVERY 16
+
+// Maximum payload [bytes]: three header bytes and 11 varints of at most five
+// bytes. Fits `DVG_FRAME_PAYLOAD`.
+#define TELEM_PAYLOAD_MAX 58
+
+struct DvG_TelemetryRecord {
+  uint32_t t;             // [us] `micros()` of the device
+  int32_t speed;          // [urev per sec] Setpoint, see `setSpeedFixed()`
+  int32_t position;       // [steps] `currentPosition()`
+  uint8_t style;          // SINGLE, DOUBLE, INTERLEAVE or MICROSTEP
+  bool running;
+  uint32_t jitter_avg;    // [us] Lateness of the steps since the previous
+  uint32_t jitter_max;    // [us] record
+  uint32_t loop_avg;      // [us] Period of `loop()` since the previous
+  uint32_t loop_max;      // [us] record
+  uint32_t leds_shown;    // Frame counters of the LED strip, cumulative
+  uint32_t leds_skipped;
+  uint32_t leds_deferred;
+  uint32_t leds_limited;
+};
+
+class DvG_TelemetryEncoder {
+ public:
+  DvG_TelemetryEncoder();
+
+  // Make the next record a key record, e.g. after a record got lost
+  void forceKey() { _sinceKey = TELEM_KEY_EVERY; }
+
+  // Encode `rec` into `payload`, which must hold `TELEM_PAYLOAD_MAX` bytes.
+  // Returns the payload length.
+  uint8_t encode(const DvG_TelemetryRecord& rec, uint8_t* payload);
+
+ private:
+  DvG_TelemetryRecord _prev;
+  uint8_t _seq;
+  uint8_t _sinceKey;  // Records since the last key record
+};
+
+class DvG_TelemetryDecoder {
+ public:
+  DvG_TelemetryDecoder();
+
+  // Decode `payload` into `rec`. Returns false when the payload is not a
+  // telemetry record, is malformed, or is a delta record without its
+  // predecessor.
+  bool decode(const uint8_t* payload, uint8_t len, DvG_TelemetryRecord& rec);
+
+  // Number of sequence gaps, i.e. lost runs of records
+  uint32_t gaps() { return _gaps; }
+
+ private:
+  DvG_TelemetryRecord _prev;
+  uint8_t _seq;     // Sequence number expected next
+  bool _fValid;     // `_prev` holds the previous record
+  uint32_t _gaps;
+};
+
+#endif
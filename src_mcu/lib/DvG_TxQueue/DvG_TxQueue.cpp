@@ -0,0 +1,160 @@
+#include "DvG_TxQueue.h"
+
+#define TXQ_MASK (TXQ_LEN - 1)
+
+DvG_TxQueue::DvG_TxQueue(Print& port) : _port(port) {
+  _head = 0;
+  _committed = 0;
+  _tail = 0;
+  _fDiscard = false;
+  _fPartial = false;
+  _unitEnd = 0;
+  _packet = 0;
+  _packetWait = 0;
+  _tCommit = 0;
+  resetStats();
+}
+
+void DvG_TxQueue::setPacket(uint8_t size, uint32_t wait_us) {
+  _packet = (size > TXQ_PACKET_MAX ? TXQ_PACKET_MAX : size);
+  _packetWait = wait_us;
+}
+
+void DvG_TxQueue::commit() {
+  if (_tail == _committed) _tCommit = micros();
+  _committed = _head;
+}
+
+size_t DvG_TxQueue::write(uint8_t c) {
+  if (_fDiscard) {
+    if (c == '\n') _fDiscard = false;
+    return 1;
+  }
+
+  if ((uint16_t)(_head - _tail) >= TXQ_LEN && !dropOldest()) {
+    // No room left for the line under construction: drop it as a whole
+    _head = _committed;
+    _fDiscard = (c != '\n');
+    _linesDropped++;
+    return 1;
+  }
+
+  _buf[_head++ & TXQ_MASK] = c;
+  if (c == '\n') {
+    commit();
+  }
+  if ((uint16_t)(_head - _tail) > _queuedMax) {
+    _queuedMax = _head - _tail;
+  }
+  return 1;
+}
+
+size_t DvG_TxQueue::write(const uint8_t* buffer, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    write(buffer[i]);
+  }
+  return size;
+}
+
+bool DvG_TxQueue::writeFrame(const uint8_t* frame, uint16_t len) {
+  if (_head != _committed || len < 2 || frame[0] != 0x00 ||
+      frame[len - 1] != 0x00) {
+    _linesDropped++;
+    return false;
+  }
+  while ((uint16_t)(TXQ_LEN - (uint16_t)(_head - _tail)) < len) {
+    if (!dropOldest()) {
+      _linesDropped++;
+      return false;
+    }
+  }
+
+  for (uint16_t i = 0; i < len; i++) {
+    _buf[_head++ & TXQ_MASK] = frame[i];
+  }
+  commit();
+  if ((uint16_t)(_head - _tail) > _queuedMax) {
+    _queuedMax = _head - _tail;
+  }
+  return true;
+}
+
+int DvG_TxQueue::availableForWrite() {
+  return TXQ_LEN - (uint16_t)(_head - _tail);
+}
+
+uint16_t DvG_TxQueue::unitEnd(uint16_t start) {
+  uint16_t i = start;
+
+  if (_buf[i & TXQ_MASK] == 0x00) {
+    // Binary frame, COBS leaves no 0x00 but the delimiters
+    for (i++; _buf[i & TXQ_MASK] != 0x00; i++) {}
+  } else {
+    for (; _buf[i & TXQ_MASK] != '\n'; i++) {}
+  }
+  return i + 1;
+}
+
+bool DvG_TxQueue::dropOldest() {
+  if (_tail == _committed || _fPartial) {
+    return false;
+  }
+
+  _tail = unitEnd(_tail);
+  _linesDropped++;
+  return true;
+}
+
+uint16_t DvG_TxQueue::drain(uint32_t budget_us) {
+  uint32_t t_start = micros();
+  uint16_t total = 0;
+  uint16_t n, i, tail;
+  size_t written;
+  uint8_t packet[TXQ_PACKET_MAX];
+  int room;
+
+  while (_tail != _committed) {
+    room = _port.availableForWrite();
+    if (room <= 0) break;
+    if (!_fPartial) _unitEnd = unitEnd(_tail);
+    tail = _tail;
+
+    if (_packet) {
+      // A full packet, or what is left once it has waited long enough
+      n = _committed - _tail;
+      if (n >= _packet) {
+        n = _packet;
+      } else if (micros() - _tCommit < _packetWait) {
+        break;
+      }
+      for (i = 0; i < n; i++) packet[i] = _buf[(_tail + i) & TXQ_MASK];
+      written = _port.write(packet, n);
+    } else {
+      // Contiguous run up to the end of the line or the ring buffer
+      n = _unitEnd - _tail;
+      if (n > TXQ_LEN - (_tail & TXQ_MASK)) n = TXQ_LEN - (_tail & TXQ_MASK);
+      if (n > room) n = room;
+      written = _port.write(&_buf[_tail & TXQ_MASK], n);
+    }
+    // A port claiming more than it was given must not move the tail past
+    // bytes that were never queued
+    if (written < n) n = written;
+    if (n == 0) break;
+    _tail += n;
+    total += n;
+
+    // Find the line or frame the tail ended up in
+    while ((uint16_t)(_tail - tail) > (uint16_t)(_unitEnd - tail)) {
+      _unitEnd = unitEnd(_unitEnd);
+    }
+    _fPartial = (_tail != _unitEnd);
+
+    if (micros() - t_start >= budget_us) break;
+  }
+  return total;
+}
+
+void DvG_TxQueue::resetStats() {
+  _queuedMax = 0;
+  _linesDropped = 0;
+}
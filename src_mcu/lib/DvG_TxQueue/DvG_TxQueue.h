@@ -0,0 +1,109 @@
+/*
+Non-blocking output queue for the replies to the serial commands. Printing
+straight to the serial port blocks as soon as its transmit buffer is full,
+e.g. when the host does not read or a burst of replies outruns the baud rate,
+and blocking `loop()` stalls the stepper. Instead, everything printed to the
+queue is formatted into a preallocated ring buffer and `drain()` passes it on
+to the port, only as many bytes as the port reports free space for and only
+within a time budget.
+
+Lines are the unit of the queue: a line is not sent before its linefeed has
+been printed. When the ring buffer is full, whole lines are dropped, oldest
+first, so the newest replies always get through and a line is never cut. The
+line that is being sent at that moment can not be dropped. When that is what
+stands in the way, the new line is dropped instead.
+
+Binary frames, see DvG_BinaryFrame.h, can be queued in between the lines
+with `writeFrame()`. They are sent and dropped as a whole, just like a line.
+
+Ports that send whole packets, like the native USB port, get the most out of
+each packet in packet mode, see `setPacket()`: lines and frames are then
+joined into full packets, and a partly filled packet is only sent once its
+oldest byte has waited for a while.
+
+Usage:
+  DvG_TxQueue Ser(Serial);
+
+  Ser.print("f = ");                 // Any `Print` method
+  Ser.println(speed);
+
+  void task_tx() { Ser.drain(200); } // Regularly, e.g. as a scheduler task
+*/
+
+#ifndef DvG_TxQueue_h
+#define DvG_TxQueue_h
+
+#include <Arduino.h>
+
+// Size [bytes] of the ring buffer, must be a power of two
+#define TXQ_LEN 1024
+
+// Maximum packet size [bytes], see `setPacket()`
+#define TXQ_PACKET_MAX 64
+
+class DvG_TxQueue : public Print {
+ public:
+  DvG_TxQueue(Print& port);
+
+  size_t write(uint8_t c);
+  size_t write(const uint8_t* buffer, size_t size);
+  using Print::write;
+
+  // Queue a complete frame, delimiters included. Returns false when the
+  // frame got dropped, which also happens when called halfway a line.
+  bool writeFrame(const uint8_t* frame, uint16_t len);
+
+  // Pass the queue on in packets of `size` bytes, at most `TXQ_PACKET_MAX`,
+  // across line and frame boundaries. A partly filled packet waits up to
+  // `wait_us` [us] for more lines. In packet mode the room the port reports
+  // only decides whether to write at all: the native USB port of the SAMD21
+  // reports one byte less than a packet, yet takes a full one per write.
+  // A `size` of 0 sends line by line again.
+  void setPacket(uint8_t size, uint32_t wait_us);
+
+  // Free space [bytes] in the ring buffer
+  int availableForWrite();
+
+  // Pass the queued lines on to the port, as far as it has room for, until
+  // the queue is empty or `budget_us` [us] is spent. Returns the number of
+  // bytes passed on.
+  uint16_t drain(uint32_t budget_us);
+
+  // Number of bytes waiting to be sent, the line under construction included
+  uint16_t queued() { return _head - _tail; }
+
+  // Largest number of bytes queued at once
+  uint16_t getQueuedMax() { return _queuedMax; }
+
+  // Number of lines and frames dropped because the ring buffer was full
+  uint32_t getLinesDropped() { return _linesDropped; }
+
+  void resetStats();
+
+ private:
+  Print& _port;
+  uint8_t _buf[TXQ_LEN];
+  uint16_t _head;       // Free-running write index
+  uint16_t _committed;  // Free-running index one past the last linefeed
+  uint16_t _tail;       // Free-running index of the next byte to send
+  bool _fDiscard;       // Drop the line under construction up to its linefeed
+  bool _fPartial;       // The oldest line has been partly sent
+  uint16_t _unitEnd;    // Free-running index one past the line being sent
+  uint8_t _packet;      // Packet size, 0: line by line
+  uint32_t _packetWait; // [us] Maximum wait of a partly filled packet
+  uint32_t _tCommit;    // [us] Time the oldest unsent line got committed
+  uint16_t _queuedMax;
+  uint32_t _linesDropped;
+
+  // Mark everything written so far as complete lines or frames
+  void commit();
+
+  // Index one past the line or frame starting at `start`
+  uint16_t unitEnd(uint16_t start);
+
+  // Drop the oldest complete line when it has not been partly sent yet.
+  // Returns false when no line could be dropped.
+  bool dropOldest();
+};
+
+#endif
@@ -59,25 +59,64 @@
 
 #include "Adafruit_MotorShield.h"
 #include "Adafruit_NeoPixel_ZeroDMA.h"
-#include "DvG_NeoPixel_Effects.h"
+#include "DvG_BinaryFrame.h"
+#include "DvG_CommandArgs.h"
+#include "DvG_CommandQueue.h"
+#include "DvG_CommandRegistry.h"
+#include "DvG_LoopProfiler.h"
+#include "DvG_EffectTimeline.h"
+#include "DvG_Scheduler.h"
+#include "DvG_Script.h"
 #include "DvG_SerialCommand.h"
 #include "DvG_Stepper.h"
+#include "DvG_Strobe.h"
+#include "DvG_Telemetry.h"
+#include "DvG_TxQueue.h"
 
 // NEOPIXEL
 // --------
 #define PIN_NEOPIXEL 5
 #define NUM_LEDS 16
 uint8_t brightness = 50; // 200
-uint8_t running_effect_no = 1;
+#define OVERRIDE_FADE 500 // [ms] Crossfade of the 'w' and 'g' overrides
+#define COLOR_WHITE 0xFF000000
+#define COLOR_GREEN 0x0000FF00
+// The LEDs share the 5 V rail with the logic. All 16 RGBW pixels at full
+// brightness would draw 16 x 4 x 20 mA = 1.28 A, so the brightness of a
+// frame gets scaled down when its estimated current exceeds this limit.
+#define LEDS_MAX_CURRENT 500 // [mA]
 
-Adafruit_NeoPixel_ZeroDMA strip(NUM_LEDS, PIN_NEOPIXEL, NEO_GRBW);
-DvG_NeoPixel_Effects npe = DvG_NeoPixel_Effects(&strip);
+Adafruit_NeoPixel_ZeroDMA_Static<NUM_LEDS, NEO_GRBW> strip(PIN_NEOPIXEL);
+DvG_EffectTimeline timeline(&strip);
+
+// clang-format off
+const DvG_TimelineStep rainbow_sequence[] = {
+  // kind,                  color,      wait, duration, fade
+  {EFFECT_RAINBOW_TEMPORAL, 0,          50,   12800,    0},
+};
+
+// Former effect cycling, crossfading from one effect into the next
+const DvG_TimelineStep demo_sequence[] = {
+  // kind,                  color,      wait, duration, fade
+  {EFFECT_FULL_COLOR,       0xFF000000, 0,    1000,     500},
+  {EFFECT_RAINBOW_SPATIAL,  0,          5,    1280,     500},
+  {EFFECT_RAINBOW_SPATIAL,  0,          1,    2560,     500},
+  {EFFECT_RAINBOW_TEMPORAL, 0,          50,   12800,    500},
+  {EFFECT_FULL_COLOR,       0x00FF0000, 0,    1000,     500},
+  {EFFECT_COLOR_WIPE,       0x0000FF00, 100,  1600,     0},
+  {EFFECT_FULL_COLOR,       0x0000FF00, 0,    1000,     500},
+  {EFFECT_COLOR_WIPE,       0x000000FF, 100,  1600,     0},
+  {EFFECT_FULL_COLOR,       0x000000FF, 0,    1000,     500},
+  {EFFECT_COLOR_WIPE,       0xFF000000, 100,  1600,     500},
+};
+// clang-format on
 
 // STEPPER
 // -------
 #define STEPS_PER_REV 200 // As specified by the stepper motor
 #define STEPPER_PORT 2    // Motor connected to port #2 (M3 and M4)
-float speed = 1.0;        // [rev per sec]
+int32_t speed = STEPPER_SPEED_ONE; // [urev per sec], see `setSpeedFixed()`
+#define SPEED_NUDGE (STEPPER_SPEED_ONE / 20) // 0.05 rev per sec
 bool oscillating = false;
 // Oscillating at fixed distance?
 // Oscillating at fixed frequency?
@@ -87,6 +126,17 @@ Adafruit_MotorShield AFMS = Adafruit_MotorShield();
 Adafruit_StepperMotor *stepper = AFMS.getStepper(STEPS_PER_REV, STEPPER_PORT);
 DvG_Stepper Astepper(stepper, STEPS_PER_REV);
 
+// STROBE
+// ------
+// Flash the LEDs once per revolution at a chosen angle, see command 'strobe'.
+// While 'osc' oscillates the motor, the angle is a phase of the oscillation
+// instead, see `applyStrobePhase()`.
+#define STROBE_COLOR 0xFF000000 // White
+DvG_Strobe strobe(Astepper, strip);
+int32_t strobe_phase = 0; // [0.01 deg]
+uint32_t osc_period = 0;  // [us] Of the oscillation of 'osc', 0: none
+uint64_t osc_t_start = 0; // [us] `micros64()` at its start, at phase 0
+
 // Set a faster I2C clock frequency, beneficial for faster stepping.
 // Arduino M0 Pro, SAMD21 chipset specs:
 //   supports: 100 kHz, 400 kHz, 1 MHz, 3.4 MHz
@@ -100,8 +150,56 @@ DvG_Stepper Astepper(stepper, STEPS_PER_REV);
 
 // SERIAL
 // ------
-#define Ser Serial
-DvG_SerialCommand sc(Ser); // Instantiate serial command listener
+// Commands are accepted on both the programming port, the EDBG bridge at
+// 115200 baud, and the native USB port, which has no baud rate to limit it.
+// The ports are polled in turn, see `task_serial()`, and each reply goes back
+// to the port its command came in on. The native USB port joins its replies
+// into full 64-byte packets, which makes it the port to stream telemetry and
+// bulk statistics over, while the programming port stays free for debugging.
+#define CMD_LEN 64 // Room for time-tagged and multi-argument commands
+#define N_PORTS 2
+#define PORT_DEBUG 0
+#define PORT_USB 1
+#define USB_PACKET 64        // [bytes] Endpoint size of the native USB port
+#define USB_PACKET_WAIT 1000 // [us] Wait of a partly filled USB packet
+DvG_SerialCommandT<CMD_LEN> sc_debug(Serial);
+DvG_SerialCommandT<CMD_LEN, Serial_> sc_usb(SerialUSB); // Bulk `readBytes()`
+DvG_SerialCommandBase *const listeners[N_PORTS] = {&sc_debug, &sc_usb};
+
+// A write to the native USB port waits until the host has fetched the packet,
+// up to 250 ms when no terminal has the port open. The queue only gets to
+// write a packet when the IN endpoint bank is free and DTR is set.
+#ifndef CDC_ENDPOINT_IN
+#define CDC_ENDPOINT_IN 3 // See USB/USBDesc.h of the SAMD core
+#endif
+
+class UsbTxPort : public Print {
+ public:
+  size_t write(uint8_t c) { return write(&c, 1); }
+  size_t write(const uint8_t *buffer, size_t size) {
+    return SerialUSB.write(buffer, size);
+  }
+  int availableForWrite() {
+    if (!SerialUSB.dtr() ||
+        USB->DEVICE.DeviceEndpoint[CDC_ENDPOINT_IN].EPSTATUS.bit.BK1RDY) {
+      return 0;
+    }
+    return SerialUSB.availableForWrite();
+  }
+};
+
+UsbTxPort usb_tx_port;
+
+// All replies go through a non-blocking queue per port, drained by the 'tx'
+// task, so a host that does not keep up reading can never stall the stepper.
+// When a queue overflows, its oldest replies are dropped.
+DvG_TxQueue tx_debug(Serial);
+DvG_TxQueue tx_usb(usb_tx_port);
+DvG_TxQueue *const tx_queues[N_PORTS] = {&tx_debug, &tx_usb};
+
+// Port of the command being handled, its replies go to `Ser`
+uint8_t cmd_port = PORT_DEBUG;
+#define Ser (*tx_queues[cmd_port])
 
 void printSpeed() {
   Ser.print("f = ");
@@ -125,194 +223,864 @@ void printSpeed() {
   }
 }
 
+void printStrobe() {
+  Ser.print("Strobe: ");
+  if (strobe.enabled()) {
+    // Like a float with 2 decimals, without the soft-float formatting
+    uint32_t phase = (strobe_phase < 0 ? -strobe_phase : strobe_phase);
+    if (strobe_phase < 0) Ser.print('-');
+    Ser.print(phase / 100);
+    Ser.print(phase % 100 < 10 ? ".0" : ".");
+    Ser.print(phase % 100);
+    Ser.println(" deg");
+  } else {
+    Ser.println("off");
+  }
+}
+
+// LATENCY
+// -------
+// When enabled with command 'lat', every speed-changing command reports the
+// `micros()` timestamps of its journey through the firmware:
+//   "lat <t_rx> <t_dispatch> <t_step>"
+//   t_rx      : linefeed received by `DvG_SerialCommand::available()`
+//   t_dispatch: command retrieved and about to be handled
+//   t_step    : first step taken at the new step interval
+// The report is sent once that first step has happened, which requires the
+// motor to be running. A time-tagged command starts its journey when it is
+// taken from the queue, so both its t_rx and t_dispatch are that moment.
+bool fReportLatency = false;
+bool fLatencyPending = false;
+uint32_t t_lat_rx = 0;
+uint32_t t_lat_dispatch = 0;
+uint32_t t_cmd_rx; // [us] t_rx of the command being handled
+
+void armLatency(uint32_t t_dispatch) {
+  fLatencyPending = fReportLatency;
+  t_lat_rx = t_cmd_rx;
+  t_lat_dispatch = t_dispatch;
+}
+
+void reportLatency() {
+  uint32_t t_step;
+
+  // Always poll, so a stale stamp never gets reported against a new command
+  if (Astepper.newSpeedStepped(t_step) && fLatencyPending) {
+    fLatencyPending = false;
+    Ser.print("lat ");
+    Ser.print(t_lat_rx);
+    Ser.print(" ");
+    Ser.print(t_lat_dispatch);
+    Ser.print(" ");
+    Ser.println(t_step);
+  }
+}
+
+// TIMED COMMANDS
+// --------------
+// Any command can be given a moment of execution on the device clock, see
+// `DvG_CommandQueue.h`: "@<t> <command>". It is answered right away by
+// "Queued @<t>" and executed at the step boundary nearest to <t>, or at <t>
+// itself when the motor is not stepping. Its reply then goes out prefixed
+// with the requested and the actual time: "at <t> <t_applied> <reply>".
+// Command 'clock' returns the device clock, so the host can map its own
+// clock onto it. The queue holds commands as long as the listeners do.
+DvG_CommandQueueT<CMD_LEN> cmd_queue;
+
+// `micros()` extended to 64 bits, so it never wraps. Has to be called at
+// least once per 71 minutes, which `trackLoop()` takes care of.
+uint64_t micros64() {
+  static uint32_t t_hi = 0;
+  static uint32_t t_prev = 0;
+  uint32_t now = micros();
+
+  if (now < t_prev) t_hi++;
+  t_prev = now;
+  return ((uint64_t)t_hi << 32) | now;
+}
+
+// `Print` has no 64-bit integers
+void printU64(uint64_t value) {
+  char buf[21];
+  char *c = &buf[20];
+
+  *c = '\0';
+  do {
+    *--c = '0' + value % 10;
+    value /= 10;
+  } while (value);
+  Ser.print(c);
+}
+
+void runTimedCommands(bool stepped);
+
+// Lock the strobe to the oscillation while there is one, else to the
+// revolution. Call again when either changes.
+void applyStrobePhase() {
+  if (osc_period) {
+    uint64_t now = micros64();
+    uint32_t t_zero = (uint32_t)(now - (now - osc_t_start) % osc_period);
+    strobe.setOscillationPhase(osc_period, strobe_phase, t_zero);
+  } else {
+    strobe.setRevolutionPhase(strobe_phase);
+  }
+}
+
+// The script no longer runs the oscillation of 'osc'
+void endOscillation() {
+  if (osc_period) {
+    osc_period = 0;
+    applyStrobePhase();
+  }
+}
+
+// SCRIPT
+// ------
+// Experiment scripts run on the device itself, see `DvG_Script.h`, so their
+// timing does not depend on the serial link. A script gets uploaded in
+// pieces by binary frames, see `FRAME_OP_SCRIPT`, and is controlled by
+// command 'script'. It is polled after every step, which anchors its
+// deadlines to the step timebase.
+class ScriptTarget : public DvG_ScriptTarget {
+ public:
+  void setSpeed(int32_t value) {
+    ::speed = value;
+    Astepper.setSpeedFixed(value);
+  }
+  int32_t speed() { return ::speed; }
+  void setStyle(uint8_t style) {
+    Astepper.setStyle(style);
+    applyStrobePhase(); // Steps per rev changed
+  }
+  void setRun(bool on) {
+    if (on) {
+      Astepper.turn_on();
+    } else {
+      Astepper.turn_off();
+    }
+  }
+  void setLed(uint32_t color, uint16_t fade) {
+    timeline.setOverride(color, fade);
+  }
+  void clearLed(uint16_t fade) { timeline.clearOverride(fade); }
+};
+
+ScriptTarget script_target;
+DvG_Script script(script_target);
+
+void printScript() {
+  Ser.print("Script: ");
+  switch (script.state()) {
+    case SCRIPT_IDLE:
+      Ser.print("idle ");
+      break;
+    case SCRIPT_RUNNING:
+      Ser.print("running ");
+      break;
+    case SCRIPT_DONE:
+      Ser.print("done ");
+      break;
+    case SCRIPT_INVALID:
+      Ser.print("invalid ");
+      break;
+  }
+  Ser.print(script.length());
+  Ser.print(" bytes pc ");
+  Ser.println(script.pc());
+}
+
+// BINARY FRAMES
+// -------------
+// Besides ASCII commands, `sc` accepts binary frames, see `DvG_BinaryFrame.h`.
+// Their payload is a sequence of operations, each an opcode byte followed by
+// its little-endian argument, so one frame can update several parameters at
+// once. Frames are not answered. Operations behave like their ASCII
+// counterparts and the first malformed one drops the rest of the frame.
+// Command 'bin' prints and resets the frame counters.
+#define FRAME_OP_SPEED 0x01      // float32 [rev per sec], like 'f<num>'
+#define FRAME_OP_STYLE 0x02      // uint8 1 - 4, like '1' to '4'
+#define FRAME_OP_BRIGHTNESS 0x03 // uint8 0 - 255
+#define FRAME_OP_RUN 0x04        // uint8 0: release, 1: run
+#define FRAME_OP_SCRIPT 0x05     // uint16 offset, uint8 n, n bytes of script
+#define FRAME_SPEED_MAX 2000.f   // [rev per sec] Fits the fixed-point speed
+uint32_t frame_op_errors = 0;
+
+void handleFrame(const uint8_t *data, uint8_t len, uint32_t t_dispatch) {
+  uint8_t i = 0;
+
+  while (i < len) {
+    uint8_t op = data[i++];
+    uint8_t left = len - i;
+    if (op == FRAME_OP_SPEED && left >= 4) {
+      float value;
+      memcpy(&value, &data[i], 4); // The SAMD21 is little-endian too
+      i += 4;
+      if (!(fabsf(value) < FRAME_SPEED_MAX)) { // NaN included
+        frame_op_errors++;
+        break;
+      }
+      speed = lroundf(value * STEPPER_SPEED_ONE);
+      armLatency(t_dispatch);
+      Astepper.setSpeedFixed(speed);
+    } else if (op == FRAME_OP_STYLE && left >= 1 && data[i] >= SINGLE &&
+               data[i] <= MICROSTEP) {
+      armLatency(t_dispatch);
+      Astepper.setStyle(data[i++]);
+      applyStrobePhase(); // Steps per rev changed
+    } else if (op == FRAME_OP_BRIGHTNESS && left >= 1) {
+      brightness = data[i++];
+      strip.setBrightness(brightness);
+    } else if (op == FRAME_OP_RUN && left >= 1) {
+      if (data[i++]) {
+        Astepper.turn_on();
+      } else {
+        Astepper.turn_off();
+      }
+    } else if (op == FRAME_OP_SCRIPT && left >= 3 &&
+               left - 3 >= data[i + 2]) {
+      uint16_t offset = data[i] | (data[i + 1] << 8);
+      uint8_t n = data[i + 2];
+      endOscillation();
+      if (!script.load(offset, &data[i + 3], n)) {
+        frame_op_errors++;
+        break;
+      }
+      i += 3 + n;
+    } else {
+      frame_op_errors++;
+      break;
+    }
+  }
+}
+
+// TELEMETRY
+// ---------
+// Command 'telem<ms>' streams a binary telemetry record every <ms>, see
+// `DvG_Telemetry.h`, and 'telem' stops the stream. The records go out as
+// binary frames through the reply queue, in between the reply lines. They are
+// taken on absolute deadlines, so the sampling does not drift. A record that
+// got dropped by the queue makes the next one a key record.
+#define TELEM_PERIOD_MIN 10    // [ms] Leaves room for replies at 115200 baud
+#define TELEM_PERIOD_MAX 60000 // [ms]
+DvG_TelemetryEncoder telem_enc;
+uint32_t telem_period = 0;  // [us], 0: off
+uint32_t telem_next = 0;    // [us] Deadline of the next record
+uint8_t telem_port = PORT_DEBUG; // Port that asked for the stream
+uint32_t telem_dropped = 0; // `getLinesDropped()` at the previous record
+
+// Period of `loop()`, summarized per record
+uint32_t loop_t_prev = 0;
+uint32_t loop_count = 0;
+uint32_t loop_sum = 0; // [us]
+uint32_t loop_max = 0; // [us]
+
+void trackLoop() {
+  uint32_t now = (uint32_t)micros64(); // Also keeps the 64-bit clock going
+  uint32_t dt = now - loop_t_prev;
+
+  loop_t_prev = now;
+  loop_count++;
+  loop_sum += dt;
+  if (dt > loop_max) loop_max = dt;
+}
+
+void resetTelemetryStats() {
+  Astepper.resetJitter();
+  loop_count = 0;
+  loop_sum = 0;
+  loop_max = 0;
+}
+
+void sendTelemetry() {
+  DvG_TelemetryRecord rec;
+  uint8_t payload[TELEM_PAYLOAD_MAX];
+  uint8_t frame[DVG_FRAME_ENCODED(TELEM_PAYLOAD_MAX)];
+  uint32_t count;
+  uint32_t now = micros();
+
+  if (!telem_period || (int32_t)(now - telem_next) < 0) return;
+  telem_next += telem_period;
+  if ((int32_t)(now - telem_next) >= 0) {
+    telem_next = now + telem_period; // Fell behind by more than a period
+  }
+
+  rec.t = now;
+  rec.speed = speed;
+  rec.position = Astepper.currentPosition();
+  rec.style = Astepper.style();
+  rec.running = Astepper.running();
+  count = Astepper.getJitterCount();
+  rec.jitter_avg = (count ? Astepper.getJitterSum() / count : 0);
+  rec.jitter_max = Astepper.getJitterMax();
+  rec.loop_avg = (loop_count ? loop_sum / loop_count : 0);
+  rec.loop_max = loop_max;
+  rec.leds_shown = strip.getFramesFull() + strip.getFramesPartial();
+  rec.leds_skipped = strip.getFramesSkipped();
+  rec.leds_deferred = strip.getFramesDeferred();
+  rec.leds_limited = strip.getFramesLimited();
+  resetTelemetryStats();
+
+  DvG_TxQueue &out = *tx_queues[telem_port];
+  if (out.getLinesDropped() != telem_dropped) {
+    telem_enc.forceKey(); // Possibly the previous record
+  }
+  if (!out.writeFrame(frame,
+                      dvgFrameEncode(payload, telem_enc.encode(rec, payload),
+                                     frame))) {
+    telem_enc.forceKey();
+  }
+  telem_dropped = out.getLinesDropped();
+}
+
+// PROFILER
+// --------
+// Cycle-count histograms of the sections of `loop()`, printed and reset with
+// command 'prof'. Only compiled in when `DVG_PROFILE_LOOP` is defined, see
+// `platformio.ini`. Otherwise the markers cost nothing.
+#ifdef DVG_PROFILE_LOOP
+enum ProfSection { PROF_LOOP, PROF_SERIAL, PROF_LEDS, PROF_STEPPER, PROF_N };
+const char *prof_names[PROF_N] = {"loop", "serial", "leds", "stepper"};
+DvG_LoopProfiler prof(prof_names, PROF_N);
+#endif
+
+// SCHEDULER
+// ---------
+// `loop()` is run by a deadline-aware scheduler, see `DvG_Scheduler.h`. The
+// stepper task runs first and in between all other tasks. The serial and LED
+// tasks only run when they fit within their time budget before the next step
+// is due, unless they got deferred for longer than their maximum deferral
+// time. The same goes for the 'tx' task that drains the reply queue. Print
+// and reset the task statistics with command 'sched'.
+#define SERIAL_BUDGET 300     // [us]
+#define SERIAL_MAX_DEFER 10000 // [us]
+#define LEDS_BUDGET 200       // [us]
+#define LEDS_MAX_DEFER 20000  // [us]
+#define TX_BUDGET 100         // [us]
+#define TX_MAX_DEFER 5000     // [us]
+
+void task_stepper();
+void task_serial();
+void task_leds();
+void task_tx();
+
+DvG_Scheduler sched(Astepper, task_stepper);
+
 /*------------------------------------------------------------------------------
     Setup
 ------------------------------------------------------------------------------*/
 
 void setup() {
-  Ser.begin(115200);
+  Serial.begin(115200);
+  SerialUSB.begin(115200); // Baud rate is ignored by the native USB port
+  tx_usb.setPacket(USB_PACKET, USB_PACKET_WAIT);
   Ser.print("Setup... ");
 
   // NeoPixel
+  strip.setDoubleBuffer(true); // Never write to the buffer being sent
   strip.begin();
   strip.setBrightness(brightness);
+  strip.setPowerLimit(LEDS_MAX_CURRENT);
   strip.show(); // Initialize all pixels to 'off'
+  strip.setDither(true); // Smooth fades at low brightness
+  dvgCrc16Begin(); // The DMA controller is up now
+  timeline.setSequence(rainbow_sequence, 1);
+  // timeline.setSequence(demo_sequence, 10);
+  strobe.setColors(STROBE_COLOR);
 
   // Stepper
   AFMS.begin(); // Create with the default maximum PWM frequency of 1.6 kHz
                 // (1526 Hz according to spec sheet)
   Astepper.turn_off();
-  Astepper.setSpeed(speed);
+  Astepper.setSpeedFixed(speed);
   Astepper.setStyle(SINGLE); // SINGLE, DOUBLE, INTERLEAVE, MICROSTEP
 
   // Set a faster I2C SCL frequency
   Wire.begin();
   Wire.setClock(I2C_SCL_FREQ);
 
+  // Scheduler
+  sched.addTask("serial", task_serial, SERIAL_BUDGET, SERIAL_MAX_DEFER);
+  sched.addTask("leds", task_leds, LEDS_BUDGET, LEDS_MAX_DEFER);
+  sched.addTask("tx", task_tx, TX_BUDGET, TX_MAX_DEFER);
+
   Ser.println("done.");
   printSpeed();
 }
 
 /*------------------------------------------------------------------------------
-    Loop
+    Tasks
 ------------------------------------------------------------------------------*/
+// Print "<prefix>n <count> avg <us> max <us>"
+void printTimeStats(const char *prefix, uint32_t count, uint32_t sum,
+                    uint32_t max) {
+  Ser.print(prefix);
+  Ser.print("n ");
+  Ser.print(count);
+  Ser.print(" avg ");
+  Ser.print(count ? sum / count : 0);
+  Ser.print(" max ");
+  Ser.println(max);
+}
+
 uint32_t tick = 0;
 uint32_t now = 0;
 uint32_t T_oscil = 250000; // [us]
+bool fOverrideWithWhite = false;
+bool fOverrideWithGreen = false;
 
-void loop() {
-  char *strCmd; // Incoming serial command string
-  static bool fOverrideWithWhite = false;
-  static bool fOverrideWithGreen = false;
-
-  // -------------------------------------------------------------------------
-  //   Process incoming serial command when available
-  // -------------------------------------------------------------------------
-
-  if (sc.available()) {
-    strCmd = sc.getCmd();
-
-    if (strcmp(strCmd, "?") == 0) {
-      Ser.println("Mini Taylor-Couette demo Pfister");
-    } else if (strcmp(strCmd, "=") == 0) {
-      brightness > 245 ? brightness = 255 : brightness += 10;
-      Ser.print("brightness: ");
-      Ser.println(brightness);
-      strip.setBrightness(brightness);
-    } else if (strcmp(strCmd, "-") == 0) {
-      brightness < 10 ? brightness = 0 : brightness -= 10;
-      Ser.print("brightness: ");
-      Ser.println(brightness);
-      strip.setBrightness(brightness);
-    } else if (strcmp(strCmd, "w") == 0) {
-      fOverrideWithWhite = not(fOverrideWithWhite);
-      fOverrideWithGreen = false;
-      Ser.print("Only white: ");
-      Ser.println(fOverrideWithWhite);
-    } else if (strcmp(strCmd, "g") == 0) {
-      fOverrideWithWhite = false;
-      fOverrideWithGreen = not(fOverrideWithGreen);
-      Ser.print("Only green: ");
-      Ser.println(fOverrideWithGreen);
-    } else if (strncmp(strCmd, "f", 1) == 0) {
-      speed = parseFloatInString(strCmd, 1);
-      Astepper.setSpeed(speed);
-      printSpeed();
-    } else if (strcmp(strCmd, ",") == 0) {
-      speed = (speed > 0 ? speed - .05 : speed + .05);
-      Astepper.setSpeed(speed);
-      printSpeed();
-    } else if (strcmp(strCmd, ".") == 0) {
-      speed = (speed > 0 ? speed + .05 : speed - .05);
-      Astepper.setSpeed(speed);
-      printSpeed();
-    } else if (strcmp(strCmd, "1") == 0) {
-      Astepper.setStyle(SINGLE);
-      printSpeed();
-    } else if (strcmp(strCmd, "2") == 0) {
-      Astepper.setStyle(DOUBLE);
-      printSpeed();
-    } else if (strcmp(strCmd, "3") == 0) {
-      Astepper.setStyle(INTERLEAVE);
-      printSpeed();
-    } else if (strcmp(strCmd, "4") == 0) {
-      Astepper.setStyle(MICROSTEP);
-      printSpeed();
-    } else {
-      if (Astepper.running()) {
-        Astepper.turn_off();
-        Ser.println("Release");
-      } else {
-        Astepper.turn_on();
-        Ser.println("Run");
-      }
-    }
-  }
-
-  // npe.fullColor(strip.Color(0, 200, 255), 1000);
+void applyOverride() {
   if (fOverrideWithGreen) {
-    // npe.fullColor(strip.Color(255, 140, 0), 1000);
-    npe.fullColor(strip.Color(0, 255, 0, 0), 1000);
+    timeline.setOverride(COLOR_GREEN, OVERRIDE_FADE);
   } else if (fOverrideWithWhite) {
-    npe.fullColor(strip.Color(0, 0, 0, 255), 1000);
+    timeline.setOverride(COLOR_WHITE, OVERRIDE_FADE);
   } else {
-    npe.rainbowTemporal(50);
+    timeline.clearOverride(OVERRIDE_FADE);
   }
+}
 
+void task_stepper() {
+  PROF_START(t_prof_stepper);
   /*
   now = micros();
   if (now - tick > T_oscil)
   {
       tick += T_oscil;
       speed = -speed;
-      Astepper.setSpeed(speed);
+      Astepper.setSpeedFixed(speed);
   }
   /*/
 
   // Step when necessary
+  bool stepped = false;
   if (Astepper.running()) {
     if (!oscillating) {
-      Astepper.runSpeed();
+      if (Astepper.runSpeed()) {
+        stepped = true;
+        strobe.poll();
+      }
     } else {
     }
   }
+  script.poll(micros(), stepped);
+  if (osc_period && script.state() != SCRIPT_RUNNING) {
+    endOscillation();
+  }
+  runTimedCommands(stepped);
+  PROF_STOP(prof, PROF_STEPPER, t_prof_stepper);
+}
 
-  /*
-  if (running_effect_no == 1) {
-      // White
-      npe.fullColor(strip.Color(0, 0, 0, 255), 1000);
+void task_leds() {
+  PROF_START(t_prof_leds);
+  timeline.update();
+
+  // Retry a frame that got deferred while the previous one was on the wire
+  if (strip.showDeferred() && strip.canShow()) {
+    strip.show();
+  }
+  // Next dithered frame once the previous one got latched
+  strip.ditherFrame();
+  PROF_STOP(prof, PROF_LEDS, t_prof_leds);
+}
+
+/*------------------------------------------------------------------------------
+    Serial commands
+------------------------------------------------------------------------------*/
+// Each command has its own handler, looked up in `commands` by `registry`,
+// see `DvG_CommandRegistry.h`. Anything unrecognised is answered by
+// "Unknown command".
+
+uint32_t t_dispatch; // [us] Command retrieved and about to be handled
+
+void cmd_identify(char *) {
+  Ser.println("Mini Taylor-Couette demo Pfister");
+}
+
+void cmd_brightnessUp(char *) {
+  brightness > 245 ? brightness = 255 : brightness += 10;
+  Ser.print("brightness: ");
+  Ser.println(brightness);
+  strip.setBrightness(brightness);
+}
+
+void cmd_brightnessDown(char *) {
+  brightness < 10 ? brightness = 0 : brightness -= 10;
+  Ser.print("brightness: ");
+  Ser.println(brightness);
+  strip.setBrightness(brightness);
+}
+
+void cmd_white(char *) {
+  fOverrideWithWhite = not(fOverrideWithWhite);
+  fOverrideWithGreen = false;
+  applyOverride();
+  Ser.print("Only white: ");
+  Ser.println(fOverrideWithWhite);
+}
 
-  } else if (running_effect_no == 2) {
-      npe.rainbowSpatial(5, 1);
-      //npe.rainbowCycle(0, 10);
+void cmd_green(char *) {
+  fOverrideWithWhite = false;
+  fOverrideWithGreen = not(fOverrideWithGreen);
+  applyOverride();
+  Ser.print("Only green: ");
+  Ser.println(fOverrideWithGreen);
+}
 
-  } else if (running_effect_no == 3) {
-      npe.rainbowSpatial(0, 10);
+void cmd_latency(char *) {
+  fReportLatency = not(fReportLatency);
+  fLatencyPending = false;
+  Ser.print("Latency report: ");
+  Ser.println(fReportLatency);
+}
 
-  } else if (running_effect_no == 4) {
-      npe.rainbowTemporal(50);
+void cmd_leds(char *) {
+  Ser.print("leds full ");
+  Ser.print(strip.getFramesFull());
+  Ser.print(" partial ");
+  Ser.print(strip.getFramesPartial());
+  Ser.print(" skipped ");
+  Ser.print(strip.getFramesSkipped());
+  Ser.print(" latched ");
+  Ser.print(strip.getFramesLatched());
+  Ser.print(" dithered ");
+  Ser.print(strip.getFramesDithered());
+  Ser.print(" deferred ");
+  Ser.print(strip.getFramesDeferred());
+  Ser.print(" limited ");
+  Ser.print(strip.getFramesLimited());
+  Ser.print(" flashes ");
+  Ser.println(strip.getStrobeFlashes());
+  printTimeStats("leds expand ", strip.getExpandCount(), strip.getExpandTime(),
+                 strip.getExpandTimeMax());
+  printTimeStats("leds wait ", strip.getWaitCount(), strip.getWaitTime(),
+                 strip.getWaitTimeMax());
+  timeline.frameStats().print(Ser, "timeline");
+  strip.resetFrameCounters();
+  timeline.frameStats().reset();
+  Ser.println("LED counters reset");
+}
 
-  } else if (running_effect_no == 5) {
-      // Red
-      npe.fullColor(strip.Color(255, 0, 0), 1000);
+void cmd_bin(char *) {
+  Ser.print("bin frames ");
+  Ser.print(listeners[cmd_port]->framesReceived());
+  Ser.print(" errors ");
+  Ser.print(listeners[cmd_port]->frameErrors());
+  Ser.print(" bad_ops ");
+  Ser.print(frame_op_errors);
+  Ser.print(" crc ");
+  Ser.println(dvgCrc16Hardware() ? "hw" : "sw");
+  listeners[cmd_port]->resetFrameCounters();
+  frame_op_errors = 0;
+  Ser.println("Frame counters reset");
+}
 
-  } else if (running_effect_no == 6) {
-      // Green
-      npe.colorWipe(strip.Color(0, 255, 0), 100);
+void cmd_sched(char *) {
+  sched.print(Ser);
+  sched.resetStats();
+  Ser.println("Scheduler reset");
+}
 
-  } else if (running_effect_no == 7) {
-      // Green
-      npe.fullColor(strip.Color(0, 255, 0), 1000);
+void cmd_prof(char *) {
+#ifdef DVG_PROFILE_LOOP
+  prof.print(Ser);
+  prof.reset();
+  Ser.println("Profiler reset");
+#else
+  Ser.println("Profiler disabled");
+#endif
+}
 
-  } else if (running_effect_no == 8) {
-      // Blue
-      npe.colorWipe(strip.Color(0, 0, 255), 100);
+void cmd_cmds(char *);
 
-  } else if (running_effect_no == 9) {
-      // Blue
-      npe.fullColor(strip.Color(0, 0, 255), 1000);
+void cmd_telem(char *strCmd) {
+  int32_t period = parseFixedInString(strCmd, 5, 0); // [ms]
 
-  } else if (running_effect_no == 10) {
-      // White
-      npe.colorWipe(strip.Color(0, 0, 0, 255), 100);
+  if (period > 0) {
+    period = constrain(period, TELEM_PERIOD_MIN, TELEM_PERIOD_MAX);
+    telem_period = period * 1000;
+    telem_next = micros();
+    telem_port = cmd_port;
+    telem_dropped = Ser.getLinesDropped();
+    telem_enc.forceKey();
+    resetTelemetryStats();
+    Ser.print("Telemetry: ");
+    Ser.print(period);
+    Ser.println(" ms");
+  } else {
+    telem_period = 0;
+    Ser.println("Telemetry: off");
   }
-  */
+}
 
-  /*
-  if (fOverrideWithWhite) {
-      npe.finish();
-      running_effect_no = 0;
+void cmd_tx(char *) {
+  Ser.print("tx queued ");
+  Ser.print(Ser.queued());
+  Ser.print(" max ");
+  Ser.print(Ser.getQueuedMax());
+  Ser.print(" dropped ");
+  Ser.println(Ser.getLinesDropped());
+  Ser.resetStats();
+  Ser.println("TX counters reset");
+}
+
+void cmd_script(char *strCmd) {
+  DvG_CommandArgs<1> args;
+
+  args.tokenize(strCmd, 6);
+  if (args.is(0, "run")) {
+    endOscillation();
+    script.start(micros());
+  } else if (args.is(0, "stop")) {
+    endOscillation();
+    script.stop();
+  } else if (args.is(0, "clear")) {
+    endOscillation();
+    script.stop();
+    script.clear();
   }
-  if (fOverrideWithGreen) {
-      npe.finish();
-      running_effect_no = 6;
+  printScript();
+}
+
+// 'osc <speed> <period>': oscillate between <speed> and -<speed> [rev per
+// sec], reversing every half <period> [ms]. Replaces the script, see
+// `DvG_Script.h`, so 'script stop' or a bare 'osc' stops oscillating. A
+// running strobe locks to the phase of the oscillation.
+void cmd_osc(char *strCmd) {
+  DvG_CommandArgs<2> args;
+  int32_t amplitude;
+  int32_t half; // [us]
+
+  args.tokenize(strCmd, 3);
+  amplitude = args.fixed(0, STEPPER_SPEED_DECIMALS);
+  half = args.fixed(1, 3) / 2; // [ms] with 3 decimals is [us]
+  script.stop();
+  script.clear();
+  if (amplitude != 0 && half > 0) {
+    // clang-format off
+    uint8_t code[] = {
+      SCRIPT_LOOP,  0, 0,
+      SCRIPT_SPEED, 0, 0, 0, 0,
+      SCRIPT_WAIT,  0, 0, 0, 0,
+      SCRIPT_SPEED, 0, 0, 0, 0,
+      SCRIPT_WAIT,  0, 0, 0, 0,
+      SCRIPT_NEXT,
+    };
+    // clang-format on
+    // The SAMD21 is little-endian too
+    memcpy(&code[4], &amplitude, 4);
+    memcpy(&code[9], &half, 4);
+    amplitude = -amplitude;
+    memcpy(&code[14], &amplitude, 4);
+    memcpy(&code[19], &half, 4);
+    script.load(0, code, sizeof(code));
+    osc_t_start = micros64();
+    script.start((uint32_t)osc_t_start);
+    osc_period = 2 * (uint32_t)half;
+  } else {
+    osc_period = 0;
   }
+  applyStrobePhase();
+  printScript();
+}
+
+void cmd_clock(char *) {
+  Ser.print("clock ");
+  printU64(micros64());
+  Ser.println();
+}
 
-  if (npe.effectIsDone()) {
-      running_effect_no++;
-      if (running_effect_no > 10) {
-      running_effect_no = 1;
+void cmd_at(char *strCmd) {
+  uint64_t t;
+  const char *command;
+
+  if (!DvG_CommandQueueBase::parse(strCmd, t, command)) {
+    Ser.println("Bad timed command");
+  } else if (!cmd_queue.fits(command)) {
+    Ser.println("Command too long");
+  } else if (!cmd_queue.push(t, command, cmd_port)) {
+    Ser.println("Queue full");
+  } else {
+    Ser.print("Queued @");
+    printU64(t);
+    Ser.println();
+  }
+}
+
+void cmd_strobe(char *strCmd) {
+  if (strlen(strCmd) > 6) {
+    strobe_phase = parseFixedInString(strCmd, 6, STROBE_PHASE_DECIMALS);
+    applyStrobePhase();
+    strobe.enable(true);
+  } else {
+    strobe.enable(false);
+  }
+  printStrobe();
+}
+
+void cmd_speed(char *strCmd) {
+  speed = parseFixedInString(strCmd, 1, STEPPER_SPEED_DECIMALS);
+  armLatency(t_dispatch);
+  Astepper.setSpeedFixed(speed);
+  printSpeed();
+}
+
+void cmd_slower(char *) {
+  speed = (speed > 0 ? speed - SPEED_NUDGE : speed + SPEED_NUDGE);
+  armLatency(t_dispatch);
+  Astepper.setSpeedFixed(speed);
+  printSpeed();
+}
+
+void cmd_faster(char *) {
+  speed = (speed > 0 ? speed + SPEED_NUDGE : speed - SPEED_NUDGE);
+  armLatency(t_dispatch);
+  Astepper.setSpeedFixed(speed);
+  printSpeed();
+}
+
+void cmd_style(char *strCmd) {
+  // '1' to '4' map onto SINGLE, DOUBLE, INTERLEAVE and MICROSTEP
+  armLatency(t_dispatch);
+  Astepper.setStyle(strCmd[0] - '0');
+  applyStrobePhase(); // Steps per rev changed
+  printSpeed();
+}
+
+void cmd_unknown(char *) { Ser.println("Unknown command"); }
+
+void cmd_toggleRun(char *) {
+  if (Astepper.running()) {
+    Astepper.turn_off();
+    Ser.println("Release");
+  } else {
+    Astepper.turn_on();
+    Ser.println("Run");
+  }
+}
+
+// clang-format off
+const DvG_Command commands[] = {
+  {"?"     , false, cmd_identify},
+  {"r"     , false, cmd_toggleRun},
+  {"="     , false, cmd_brightnessUp},
+  {"-"     , false, cmd_brightnessDown},
+  {"w"     , false, cmd_white},
+  {"g"     , false, cmd_green},
+  {"lat"   , false, cmd_latency},
+  {"leds"  , false, cmd_leds},
+  {"bin"   , false, cmd_bin},
+  {"sched" , false, cmd_sched},
+  {"prof"  , false, cmd_prof},
+  {"cmds"  , false, cmd_cmds},
+  {"tx"    , false, cmd_tx},
+  {"telem" , true , cmd_telem},
+  {"script", true , cmd_script},
+  {"osc"   , true , cmd_osc},
+  {"clock" , false, cmd_clock},
+  {"@"     , true , cmd_at},
+  {"strobe", true , cmd_strobe},
+  {"f"     , true , cmd_speed},
+  {","     , false, cmd_slower},
+  {"."     , false, cmd_faster},
+  {"1"     , false, cmd_style},
+  {"2"     , false, cmd_style},
+  {"3"     , false, cmd_style},
+  {"4"     , false, cmd_style},
+};
+// clang-format on
+
+#define N_COMMANDS (sizeof(commands) / sizeof(commands[0]))
+static_assert(N_COMMANDS <= CMD_N_MAX, "Too many commands, raise CMD_N_MAX");
+DvG_CommandRegistry registry(commands, N_COMMANDS, cmd_unknown);
+
+void cmd_cmds(char *) {
+  registry.print(Ser);
+  registry.resetStats();
+  Ser.println("Command counters reset");
+}
+
+void runTimedCommands(bool stepped) {
+  uint64_t t;
+  char strCmd[CMD_LEN];
+
+  while (!cmd_queue.empty()) {
+    uint64_t now = micros64();
+    int64_t left = (int64_t)(cmd_queue.nextTime() - now); // [us]
+
+    if (Astepper.running() && speed != 0) {
+      // Only right after a step, when the next one is further away than <t>
+      if (!stepped || left > (int64_t)(Astepper.timeUntilNextStep() / 2)) {
+        return;
       }
+    } else if (left > 0) {
+      return;
+    }
+
+    cmd_port = cmd_queue.nextTag(); // Reply to the port it came in on
+    cmd_queue.pop(t, strCmd);
+    t_dispatch = t_cmd_rx = micros();
+    Ser.print("at ");
+    printU64(t);
+    Ser.print(" ");
+    printU64(now);
+    Ser.print(" ");
+    registry.dispatch(strCmd);
+  }
+}
+
+// Port to poll first, the one after the port served last, so that a flood of
+// commands on one port can not lock out the other
+uint8_t port_next = PORT_DEBUG;
+
+void task_serial() {
+  PROF_START(t_prof_serial);
+  for (uint8_t k = 0; k < N_PORTS; k++) {
+    uint8_t i = (port_next + k) % N_PORTS;
+    DvG_SerialCommandBase &sc = *listeners[i];
+    if (!sc.available()) continue;
+
+    uint8_t frame_len;
+    const uint8_t *frame = sc.getFrame(frame_len); // NULL for ASCII commands
+    char *strCmd = sc.getCmd();
+    t_dispatch = micros();
+    t_cmd_rx = sc.rxTime();
+    cmd_port = i;
+    port_next = (i + 1) % N_PORTS;
+
+    if (frame) {
+      handleFrame(frame, frame_len, t_dispatch);
+    } else {
+      registry.dispatch(strCmd);
+    }
+    break; // One command per call
   }
-  */
+  reportLatency();
+  PROF_STOP(prof, PROF_SERIAL, t_prof_serial);
+}
+
+// Port to drain first, alternating, so that a busy port can not take the
+// whole budget every time. What one port leaves unused goes to the other.
+uint8_t tx_next = PORT_DEBUG;
+
+void task_tx() {
+  uint32_t t_start;
+  uint32_t spent;
+
+  sendTelemetry();
+  t_start = micros();
+  for (uint8_t k = 0; k < N_PORTS; k++) {
+    spent = micros() - t_start;
+    if (spent >= TX_BUDGET) break;
+    tx_queues[(tx_next + k) % N_PORTS]->drain(TX_BUDGET - spent);
+  }
+  tx_next = (tx_next + 1) % N_PORTS;
+}
+
+/*------------------------------------------------------------------------------
+    Loop
+------------------------------------------------------------------------------*/
+
+void loop() {
+  PROF_PERIOD(prof, PROF_LOOP);
+  trackLoop();
+  sched.run();
 }